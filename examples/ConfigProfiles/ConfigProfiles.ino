@@ -0,0 +1,82 @@
+/*
+ * ConfigProfiles example for QuickMpr121
+ * ======================================
+ *
+ * Shares one settings profile stored in flash (PROGMEM) between several MPR121s, and logs digital touch readings to serial
+ *
+ * This needs the MPR121_CONFIG_PROFILES define in QuickMpr121.h changed to true
+ */
+
+#include <QuickMpr121.h>
+
+#if !MPR121_CONFIG_PROFILES
+  #error "change the MPR121_CONFIG_PROFILES define in QuickMpr121.h to true to use this example"
+#endif
+
+
+#define NUM_MPRS 4 // must be using sequential addresses starting at 0x5a, max 4 MPR121s
+
+
+// the profile is set up at compile time, so it can live in flash instead of RAM
+// values are in the same order as in mpr121Config (MPR121_CONFIG_DEFAULTS in QuickMpr121.h is a good starting point to copy)
+// for a profile with default settings, this could just be `const mpr121Config profile PROGMEM = MPR121_CONFIG_DEFAULTS;`
+const mpr121Config profile PROGMEM = {
+  MPR121_CONFIG_THRESHOLDS(0x0c, 0x08), // lower touch and release thresholds than default, for all electrodes
+  0x01, 0x01, // MHD rising, falling
+  0x01, 0x03, 0x00, // NHD rising, falling, touched
+  0x04, 0xc0, 0x00, // NCL rising, falling, touched
+  0x00, 0x02, 0x00, // FDL rising, falling, touched
+  0x20, 0x01, // proximity MHD rising, falling
+  0x10, 0x03, 0x00, // proximity NHD rising, falling, touched
+  0x04, 0xc0, 0x00, // proximity NCL rising, falling, touched
+  0x00, 0x80, 0x00, // proximity FDL rising, falling, touched
+  0x01, 0x01, // debounce touch, release (one extra sample)
+  MPR_FFI_6, 16, MPR_CDT_0_5, MPR_SFI_4, MPR_ESI_2, // first filter, global CDC and CDT, second filter, sample interval (2ms instead of 1ms)
+  MPR_CL_TRACKING_ENABLED, MPR_ELEPROX_DISABLED, // calibration lock, proximity electrodes
+  256L * (3200 - 700) / 3200, 0, 0, // autoconfig USL (based on 3.2V), LSL and TL (0 to set automatically)
+  MPR_AUTOCONFIG_RETRY_DISABLED, MPR_AUTOCONFIG_BVA_SET_CLEAR3,
+  true, true, // autoconfig reconfig, calibration
+  false, false, false, false // autoconfig skip charge time, OOR, ARF, ACF interrupts
+};
+
+
+// create the mpr121 instances
+// these will have addresses set automatically
+mpr121 mprs[NUM_MPRS];
+
+void setup() {
+  for (int i = 0; i < NUM_MPRS; i++) {
+    // this special line makes `mpr` the same as typing `mprs[i]`
+    mpr121 &mpr = mprs[i];
+
+    // `mpr.begin()` sets up the Wire library
+    mpr.begin();
+
+    // use the PROGMEM profile (setConfig_P reads it from flash when starting)
+    // for a profile in RAM, use `mpr.setConfig(&profile)` instead
+    mpr.setConfig_P(&profile);
+
+    // start sensing (for 12 electrodes)
+    mpr.start(12);
+  }
+
+  // open the serial port
+  Serial.begin(115200);
+  while(!Serial) {} // wait for serial to be ready on USB boards
+}
+
+void loop() {
+  for (int i = 0; i < NUM_MPRS; i++) {
+    mpr121 &mpr = mprs[i];
+
+    short touches = mpr.readTouchState();
+    for (int j = 0; j < 12; j++) {
+      Serial.print(bitRead(touches, j));
+      Serial.print(" ");
+    }
+
+    Serial.print(" ");
+  }
+  Serial.println();
+  delay(10);
+}
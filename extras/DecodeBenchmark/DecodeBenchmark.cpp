@@ -0,0 +1,102 @@
+/*
+ * DecodeBenchmark for QuickMpr121
+ * ===============================
+ * 
+ * Host-side benchmark and bit-exactness check for the bulk frame decoder (QuickMpr121Decode.h).
+ * 
+ * Build and run from this folder:
+ *   g++ -O2 -I../../src ../../src/QuickMpr121Decode.cpp DecodeBenchmark.cpp -o DecodeBenchmark && ./DecodeBenchmark
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "QuickMpr121Decode.h"
+
+
+#define NUM_FRAMES 1000000
+#define FRAME_STRIDE 48 // same as a recording (sizeof(mpr121Record))
+#define FRAME_OFFSET 5 // offset of registers in a recorded frame
+#define ITERATIONS 10
+
+
+// buffers for one decoder implementation's output
+struct outputBuffers {
+  std::vector<int16_t> data[3][13];
+  mpr121DecodedFrames frames;
+
+  outputBuffers() {
+    for (int i = 0; i < 13; i++) {
+      for (int j = 0; j < 3; j++)
+        data[j][i].resize(NUM_FRAMES);
+
+      frames.filtered[i] = data[0][i].data();
+      frames.baseline[i] = data[1][i].data();
+      frames.delta[i] = data[2][i].data();
+    }
+  }
+};
+
+
+int main() {
+  // random register contents are fine -- the decoder has to handle every bit pattern identically
+  std::vector<uint8_t> recording(NUM_FRAMES * FRAME_STRIDE);
+  srand(121);
+  for (size_t i = 0; i < recording.size(); i++)
+    recording[i] = rand();
+
+  const uint8_t* frames = recording.data() + FRAME_OFFSET;
+  size_t count = NUM_FRAMES - 1; // last frame doesn't have a full stride after it, don't make the benchmark harder to read by handling that
+
+  // reference decode, written exactly like mpr121::readElectrodeData() and mpr121::readElectrodeBaseline()
+  outputBuffers reference;
+  for (size_t n = 0; n < count; n++) {
+    const uint8_t* rawdata = frames + n * FRAME_STRIDE;
+    for (int i = 0; i < 13; i++) {
+      short filtered = rawdata[0x04 + i*2] | ((rawdata[0x04 + i*2 + 1] & 0b00000011) << 8);
+      short baseline = rawdata[0x1e + i];
+      reference.data[0][i][n] = filtered;
+      reference.data[1][i][n] = baseline << 2;
+      reference.data[2][i][n] = filtered - (baseline << 2);
+    }
+  }
+
+  const mpr121DecodeImpl impls[] = { MPR_DECODE_SCALAR, MPR_DECODE_SSE2, MPR_DECODE_AVX2 };
+  const char* names[] = { "scalar", "SSE2", "AVX2" };
+  double scalarNs = 0;
+  int result = 0;
+
+  for (int impl = 0; impl < 3; impl++) {
+    if (!mpr121DecodeSupported(impls[impl])) {
+      printf("%-8s not supported\n", names[impl]);
+      continue;
+    }
+
+    outputBuffers out;
+    double bestNs = 1e30;
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+      auto start = std::chrono::steady_clock::now();
+      mpr121DecodeFrames(frames, FRAME_STRIDE, count, out.frames, impls[impl]);
+      double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      if (ns < bestNs)
+        bestNs = ns;
+    }
+
+    bool exact = true;
+    for (int j = 0; j < 3; j++)
+      for (int i = 0; i < 13; i++)
+        if (memcmp(out.data[j][i].data(), reference.data[j][i].data(), count * sizeof(int16_t)) != 0)
+          exact = false;
+
+    if (impl == 0)
+      scalarNs = bestNs;
+
+    printf("%-8s %8.2f ns/frame  %5.2fx  %s\n", names[impl], bestNs / count, scalarNs / bestNs, exact ? "bit-exact" : "MISMATCH");
+    if (!exact)
+      result = 1;
+  }
+
+  return result;
+}
@@ -0,0 +1,144 @@
+/*
+ * ModelSweep for QuickMpr121
+ * ==========================
+ *
+ * Host-side sweep of filter, charge, threshold, and debounce settings using the front end model (QuickMpr121Model.h).
+ * Runs every combination over a synthetic trace (drifting capacitance, noise, touches, and short glitches that shouldn't count as touches)
+ * and prints the fastest configurations that detected every touch without any false triggers.
+ *
+ * To use recorded data instead, convert filtered data to capacitance with mpr121AfeModel::getCapacitance() using the charge settings it was recorded with.
+ *
+ * Build and run from this folder:
+ *   g++ -O2 -I../../src ../../src/QuickMpr121Model.cpp ModelSweep.cpp -o ModelSweep && ./ModelSweep
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "QuickMpr121Model.h"
+
+
+#define TRACE_SECONDS 60
+#define TRACE_INTERVAL 250 // μs
+#define ELECTRODE_PF 20.0f
+#define TOUCH_PF 0.5f
+#define GLITCH_PF 0.6f
+#define SHOW_BEST 10
+
+
+struct candidate {
+  mpr121ModelConfig config;
+  mpr121ModelResult result;
+};
+
+
+// uniform random float in [lo, hi)
+static float randRange(float lo, float hi) {
+  return lo + (hi - lo) * (rand() / (RAND_MAX + 1.0f));
+}
+
+
+int main() {
+  // synthetic trace
+  size_t count = TRACE_SECONDS * 1000000UL / TRACE_INTERVAL;
+  std::vector<float> capacitance(count);
+  std::vector<uint8_t> touched(count);
+  srand(121);
+
+  size_t next = 0;
+  while (next < count) {
+    size_t gap = randRange(300, 1500) * 1000 / TRACE_INTERVAL;
+    size_t glitchAt = next + gap / 2;
+    next += gap;
+
+    // a short glitch (ESD, a brush past the electrode) in the middle of some gaps
+    if (rand() % 3 == 0) {
+      for (size_t i = glitchAt; i < glitchAt + 2000 / TRACE_INTERVAL && i < count; i++)
+        capacitance[i] += GLITCH_PF;
+    }
+
+    size_t length = randRange(50, 400) * 1000 / TRACE_INTERVAL;
+    for (size_t i = next; i < next + length && i < count; i++) {
+      capacitance[i] += TOUCH_PF;
+      touched[i] = 1;
+    }
+    next += length;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    float seconds = i * (TRACE_INTERVAL / 1000000.0f);
+    capacitance[i] += ELECTRODE_PF + 0.3f * sinf(seconds * 0.3f) + randRange(-0.02f, 0.02f);
+  }
+
+  mpr121ModelTrace trace = { capacitance.data(), touched.data(), count, TRACE_INTERVAL };
+  mpr121AfeModel model;
+
+  const uint8_t thresholds[][2] = { { 8, 4 }, { 15, 10 }, { 24, 16 } };
+
+  std::vector<candidate> candidates;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int FFI = 0; FFI < 4; FFI++)
+  for (int SFI = 0; SFI < 4; SFI++)
+  for (int ESI = 0; ESI < 5; ESI++)
+  for (int CDT = 1; CDT < 5; CDT++)
+  for (int DT = 0; DT < 4; DT++)
+  for (int DR = 0; DR < 2; DR++)
+  for (int th = 0; th < 3; th++) {
+    candidate c;
+    c.config.setDefaults();
+    c.config.FFI = (mpr121FilterFFI)FFI;
+    c.config.SFI = (mpr121FilterSFI)SFI;
+    c.config.ESI = (mpr121FilterESI)ESI;
+    c.config.CDT = (mpr121FilterCDT)CDT;
+    c.config.debounceTouch = DT;
+    c.config.debounceRelease = DR;
+    c.config.touchThreshold = thresholds[th][0];
+    c.config.releaseThreshold = thresholds[th][1];
+
+    // pick CDC like auto-configuration would, aiming for about 70% of vdd
+    int CDC = lroundf(0.7f * model.vdd * ELECTRODE_PF / mpr121AfeModel::getChargeMicros(c.config.CDT));
+    if (CDC < 1 || CDC > 63)
+      continue;
+    c.config.CDC = CDC;
+
+    c.result = model.run(c.config, trace);
+    candidates.push_back(c);
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%zu configurations over %d s of trace in %.2f s\n\n", candidates.size(), TRACE_SECONDS, seconds);
+
+  // keep configurations that got everything right, fastest worst-case latency first, then lowest power
+  std::vector<candidate> good;
+  for (const candidate &c : candidates) {
+    if (c.result.missed == 0 && c.result.falseTouches == 0)
+      good.push_back(c);
+  }
+  std::sort(good.begin(), good.end(), [](const candidate &a, const candidate &b) {
+    if (a.result.maxTouchLatencyMicros != b.result.maxTouchLatencyMicros)
+      return a.result.maxTouchLatencyMicros < b.result.maxTouchLatencyMicros;
+    return a.result.averageMicroAmps < b.result.averageMicroAmps;
+  });
+
+  printf("%zu with no missed or false touches (of %u touches)\n", good.size(), candidates.empty() ? 0 : candidates[0].result.touches);
+  printf(" FFI SFI ESI(ms) CDC CDT(us) TTH RTH DT DR | touch ms (mean/max) | release ms (mean/max) |   uA\n");
+
+  for (size_t i = 0; i < good.size() && i < SHOW_BEST; i++) {
+    const mpr121ModelConfig &c = good[i].config;
+    const mpr121ModelResult &r = good[i].result;
+    const int ffi[] = { 6, 10, 18, 34 };
+    const int sfi[] = { 4, 6, 10, 18 };
+    printf(" %3d %3d %7d %3d %7.1f %3d %3d %2d %2d | %8.1f %8.1f   | %8.1f %8.1f     | %6.1f\n",
+      ffi[c.FFI], sfi[c.SFI], 1 << c.ESI, c.CDC, mpr121AfeModel::getChargeMicros(c.CDT),
+      c.touchThreshold, c.releaseThreshold, c.debounceTouch, c.debounceRelease,
+      r.meanTouchLatencyMicros / 1000.0, r.maxTouchLatencyMicros / 1000.0,
+      r.meanReleaseLatencyMicros / 1000.0, r.maxReleaseLatencyMicros / 1000.0,
+      r.averageMicroAmps);
+  }
+
+  return 0;
+}
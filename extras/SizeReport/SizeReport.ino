@@ -0,0 +1,52 @@
+/*
+ * SizeReport sketch for QuickMpr121
+ * =================================
+ * 
+ * Uses every feature that's enabled by the MPR121_FEATURE_* defines, so flash/RAM usage can be compared between build profiles.
+ * This isn't meant to be run -- use size_report.sh to build it with each profile and print the results.
+ */
+
+#include <QuickMpr121.h>
+
+
+mpr121 mpr = mpr121();
+
+void setup() {
+  Serial.begin(115200);
+  
+  mpr.begin();
+  mpr.start(8);
+
+  #if MPR121_FEATURE_CHARGE
+    mpr.writeElectrodeCDC(0, 8, 16);
+    mpr.writeElectrodeCDT(0, 8, MPR_CDT_0_5);
+    Serial.println(mpr.readElectrodeCDC(0));
+    Serial.println(mpr.readElectrodeCDT(0));
+  #endif
+
+  #if MPR121_FEATURE_GPIO
+    mpr.setGPIOMode(8, 4, MPR_GPIO_MODE_OUTPUT_OPENDRAIN_HIGH);
+    mpr.writeGPIODigital(8, true);
+    mpr.writeGPIOAnalog(9, 3, 8);
+  #endif
+
+  #if MPR121_FEATURE_APPLY
+    mpr.ESI = MPR_ESI_2;
+    mpr.apply();
+  #endif
+}
+
+void loop() {
+  Serial.println(mpr.readTouchState());
+
+  #if MPR121_FEATURE_ANALOG
+    short* data = mpr.readElectrodeData(0, 8);
+    short* deltas = mpr.readElectrodeDelta(0, 8);
+    for (byte i = 0; i < 8; i++) {
+      Serial.println(data[i]);
+      Serial.println(deltas[i]);
+    }
+  #endif
+
+  delay(10);
+}
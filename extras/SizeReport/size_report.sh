@@ -0,0 +1,23 @@
+#!/bin/sh
+# Builds SizeReport.ino with different MPR121_FEATURE_* profiles and prints flash/RAM usage for each.
+# Requires arduino-cli with the target core installed.
+#
+# usage: ./size_report.sh [fqbn]   (default: arduino:avr:uno)
+
+FQBN=${1:-arduino:avr:uno}
+cd "$(dirname "$0")"
+
+report() {
+  name=$1
+  flags=$2
+  
+  echo "== $name"
+  arduino-cli compile --fqbn "$FQBN" --library ../.. --build-property "compiler.cpp.extra_flags=$flags" . 2>&1 \
+    | grep -E "^(Sketch uses|Global variables use)"
+}
+
+report "full" "-DMPR121_FEATURE_APPLY=true"
+report "default" ""
+report "touch+analog" "-DMPR121_FEATURE_CHARGE=false -DMPR121_FEATURE_GPIO=false -DMPR121_FEATURE_TRANSPORT=false -DMPR121_FEATURE_APPLY=false -DMPR121_FEATURE_BUDGET=false -DMPR121_FEATURE_BATCH=false"
+report "touch+gpio" "-DMPR121_FEATURE_ANALOG=false -DMPR121_FEATURE_CHARGE=false -DMPR121_FEATURE_TRANSPORT=false -DMPR121_FEATURE_APPLY=false -DMPR121_FEATURE_BUDGET=false -DMPR121_FEATURE_BATCH=false"
+report "touch only" "-DMPR121_FEATURE_ANALOG=false -DMPR121_FEATURE_CHARGE=false -DMPR121_FEATURE_GPIO=false -DMPR121_FEATURE_TRANSPORT=false -DMPR121_FEATURE_APPLY=false -DMPR121_FEATURE_BUDGET=false -DMPR121_FEATURE_BATCH=false"
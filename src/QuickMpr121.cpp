@@ -9,14 +9,24 @@
  */
 
 #include "QuickMpr121.h"
+#include "QuickMpr121Budget.h"
 
-byte mpr121::i2cReadBuf[MPR121_I2C_BUFLEN];
+#if MPR121_READER_THREAD
+  thread_local byte mpr121::i2cReadBuf[MPR121_I2C_BUFLEN];
+#else
+  byte mpr121::i2cReadBuf[MPR121_I2C_BUFLEN];
+#endif
 
 #if MPR121_SAVE_MEMORY
-  short mpr121::electrodeDataBuf[13];
-  byte mpr121::electrodeBaselineBuf[13];
-  byte mpr121::electrodeCDCBuf[13];
-  mpr121FilterCDT mpr121::electrodeCDTBuf[13];
+  #if MPR121_FEATURE_ANALOG
+    short mpr121::electrodeDataBuf[13];
+    byte mpr121::electrodeBaselineBuf[13];
+    short mpr121::electrodeDeltaBuf[13];
+  #endif
+  #if MPR121_FEATURE_CHARGE
+    byte mpr121::electrodeCDCBuf[13];
+    mpr121FilterCDT mpr121::electrodeCDTBuf[13];
+  #endif
   #if !MPR121_USE_BITFIELDS
     bool mpr121::electrodeOORBuf[15];
   #endif
@@ -24,10 +34,39 @@ byte mpr121::i2cReadBuf[MPR121_I2C_BUFLEN];
 
 // Writes a value to an MPR121 register.
 void mpr121::writeRegister(mpr121Register addr, byte value) {
-  i2cWire->beginTransmission(i2cAddr);
-  i2cWire->write(addr);
-  i2cWire->write(value);
-  i2cWire->endTransmission();
+  writeRegister(addr, &value, 1);
+}
+
+// Writes values to consecutive MPR121 registers in one transaction.
+// Max count is equal to the MPR121_I2C_BUFLEN define minus one (for the address byte).
+void mpr121::writeRegister(mpr121Register addr, const byte* values, byte count) {
+  if (count > MPR121_I2C_BUFLEN - 1)
+    count = MPR121_I2C_BUFLEN - 1;
+  
+  #if MPR121_FEATURE_APPLY
+    if (trackConfigWrite(addr, values, count))
+      return;
+  #endif
+  
+  #if MPR121_FEATURE_BATCH
+    if (batchDepth && queueWrite(addr, values, count))
+      return;
+  #endif
+  
+  sendWrite(addr, values, count);
+}
+
+// Writes values to consecutive MPR121 registers.
+// Unlike writeRegister, count isn't limited (writes are split into MPR121_I2C_BUFLEN - 1 chunks as necessary).
+void mpr121::writeRegisters(mpr121Register addr, const byte* values, byte count) {
+  while (count > 0) {
+    byte chunk = count > MPR121_I2C_BUFLEN - 1 ? MPR121_I2C_BUFLEN - 1 : count;
+    writeRegister(addr, values, chunk);
+    
+    addr = (mpr121Register)(addr + chunk);
+    values += chunk;
+    count -= chunk;
+  }
 }
 
 // Reads bytes from consecutive MPR121 registers, starting at addr.
@@ -36,6 +75,85 @@ byte* mpr121::readRegister(mpr121Register addr, byte count) {
   if (count > MPR121_I2C_BUFLEN)
     count = MPR121_I2C_BUFLEN;
   
+  #if MPR121_FEATURE_APPLY
+    // while capturing, config registers read back what was captured
+    if (configCapture && addr >= MPRREG_MHD_RISING && addr + count <= MPRREG_MHD_RISING + MPR121_RAW_CONFIG_LEN) {
+      memcpy(i2cReadBuf, &configCapture[addr - MPRREG_MHD_RISING], count);
+      return i2cReadBuf;
+    }
+  #endif
+  
+  #if MPR121_FEATURE_BUDGET
+    if (!budget || !budgetRead(addr, i2cReadBuf, count))
+  #endif
+  {
+    byte readnum = busRead(addr, i2cReadBuf, count);
+
+    // if not fully read, clear additional bytes to avoid returning old data
+    for ( ; readnum < count; readnum++)
+    {
+      i2cReadBuf[readnum] = 0;
+    }
+  }
+  
+  #if MPR121_FEATURE_BATCH
+    // reads see writes that are still queued
+    for (byte i = 0; i < batchCount; i++) {
+      byte offset = batchRegs[i] - addr;
+      if (offset < count)
+        i2cReadBuf[offset] = batchValues[i];
+    }
+  #endif
+  
+  return i2cReadBuf;
+}
+
+// Reads bytes from consecutive MPR121 registers into dest.
+// Unlike readRegister, count isn't limited (reads are split into MPR121_I2C_BUFLEN chunks as necessary).
+void mpr121::readRegisters(mpr121Register addr, byte count, byte* dest) {
+  while (count > 0) {
+    byte chunk = count > MPR121_I2C_BUFLEN ? MPR121_I2C_BUFLEN : count;
+    memcpy(dest, readRegister(addr, chunk), chunk);
+    
+    addr = (mpr121Register)(addr + chunk);
+    dest += chunk;
+    count -= chunk;
+  }
+}
+
+// Sends a write, budgeted if a bus budget is set (no capturing or batching).
+void mpr121::sendWrite(mpr121Register addr, const byte* values, byte count) {
+  #if MPR121_FEATURE_BUDGET
+    if (budget && budgetWrite(addr, values, count))
+      return;
+  #endif
+  
+  busWrite(addr, values, count);
+}
+
+// Sends a write to the transport or TwoWire instance (no capturing or budgeting).
+void mpr121::busWrite(mpr121Register addr, const byte* values, byte count) {
+  #if MPR121_FEATURE_TRANSPORT
+    if (transport) {
+      transport->write(i2cAddr, addr, values, count);
+      return;
+    }
+  #endif
+  
+  i2cWire->beginTransmission(i2cAddr);
+  i2cWire->write(addr);
+  i2cWire->write(values, count);
+  i2cWire->endTransmission();
+}
+
+// Sends a read to the transport or TwoWire instance (no capturing or budgeting).
+// Returns the number of bytes actually read.
+byte mpr121::busRead(mpr121Register addr, byte* dest, byte count) {
+  #if MPR121_FEATURE_TRANSPORT
+    if (transport)
+      return transport->read(i2cAddr, addr, dest, count);
+  #endif
+  
   // write the address to read from
   i2cWire->beginTransmission(i2cAddr);
   i2cWire->write(addr);
@@ -46,19 +164,326 @@ byte* mpr121::readRegister(mpr121Register addr, byte count) {
   byte readnum = 0;
   while (i2cWire->available() && readnum < count)
   {
-    i2cReadBuf[readnum] = i2cWire->read();
+    dest[readnum] = i2cWire->read();
     readnum++;
   }
 
-  // if not fully read, clear additional bytes to avoid returning old data
-  for ( ; readnum < count; readnum++)
-  {
-    i2cReadBuf[readnum] = 0;
+  return readnum;
+}
+
+
+#if MPR121_FEATURE_BUDGET
+// Limits this device's bus traffic with a budget (see mpr121BusBudget, QuickMpr121Budget.h).
+// Share one budget between all devices on a bus. Pass nullptr to stop budgeting.
+void mpr121::setBusBudget(mpr121BusBudget* budget) {
+  #if MPR121_FEATURE_GPIO
+    if (this->budget)
+      flushLEDWrites(true);
+    ledPWMKnown = 0;
+  #endif
+  
+  this->budget = budget;
+}
+
+// Gets the budget priority class of a transaction.
+mpr121BusPriority mpr121::getBusPriority(mpr121Register addr, byte count, bool read) {
+  if (count == 1 && (addr == MPRREG_GPIO_DATA || (addr >= MPRREG_GPIO_DATA_SET && addr <= MPRREG_GPIO_DATA_TOGGLE) ||
+      (addr >= MPRREG_PWM_DUTY_0 && addr <= MPRREG_PWM_DUTY_3)))
+    return MPR_PRIORITY_LED;
+  
+  if (read && addr + count <= MPRREG_ELE0_FILTERED_DATA_LSB)
+    return MPR_PRIORITY_TOUCH;
+  if (read && addr < MPRREG_MHD_RISING)
+    return MPR_PRIORITY_ANALOG;
+  
+  return MPR_PRIORITY_DIAGNOSTIC;
+}
+
+// Waits for (or takes) budget for a write, and handles deferred LED writes.
+// Returns true if the write was deferred and shouldn't be sent yet.
+bool mpr121::budgetWrite(mpr121Register addr, const byte* values, byte count) {
+  mpr121BusPriority priority = getBusPriority(addr, count, false);
+  unsigned long cost = budget->getTransactionMicros(count, false);
+  
+  #if MPR121_FEATURE_GPIO
+    if (hasDeferredLEDWrites()) {
+      // GPIO config and soft reset have to happen after deferred LED writes
+      bool wait = priority != MPR_PRIORITY_LED && addr + count > MPRREG_GPIO_CONTROL_0;
+      flushLEDWrites(wait);
+    }
+    
+    if (priority == MPR_PRIORITY_LED) {
+      // once an LED write is deferred, later ones are merged with it to keep them in order
+      if (hasDeferredLEDWrites() || !budget->take(priority, cost)) {
+        deferLEDWrite(addr, values[0]);
+        return true;
+      }
+      
+      if (addr >= MPRREG_PWM_DUTY_0) {
+        ledPWM[addr - MPRREG_PWM_DUTY_0] = values[0];
+        bitSet(ledPWMKnown, addr - MPRREG_PWM_DUTY_0);
+      }
+      return false;
+    }
+    
+    if (addr + count > MPRREG_PWM_DUTY_0)
+      ledPWMKnown = 0; // PWM registers written some other way
+  #else
+    (void)values; // only LED writes look at the values
+  #endif
+  
+  budget->acquire(priority, cost);
+  return false;
+}
+
+// Waits for budget for a read, and handles deferred LED writes.
+// Returns true if the read was already done (or answered from known PWM values) into dest.
+bool mpr121::budgetRead(mpr121Register addr, byte* dest, byte count) {
+  #if !MPR121_FEATURE_GPIO
+    (void)dest; // only PWM reads are answered here
+  #endif
+  
+  #if MPR121_FEATURE_GPIO
+    // PWM values are read before each PWM write, so answering from ledPWM saves a transaction per LED update
+    if (count == 1 && addr >= MPRREG_PWM_DUTY_0 && addr <= MPRREG_PWM_DUTY_3 && bitRead(ledPWMKnown, addr - MPRREG_PWM_DUTY_0)) {
+      dest[0] = ledPWM[addr - MPRREG_PWM_DUTY_0];
+      return true;
+    }
+    
+    if (hasDeferredLEDWrites()) {
+      // reads of GPIO registers have to see deferred LED writes
+      bool wait = addr + count > MPRREG_GPIO_CONTROL_0;
+      flushLEDWrites(wait);
+    }
+  #endif
+  
+  budget->acquire(getBusPriority(addr, count, true), budget->getTransactionMicros(count, true));
+  
+  #if MPR121_FEATURE_GPIO
+    if (count == 1 && addr >= MPRREG_PWM_DUTY_0 && addr <= MPRREG_PWM_DUTY_3) {
+      // remember the value so the next read can be skipped
+      if (busRead(addr, dest, 1) == 1) {
+        ledPWM[addr - MPRREG_PWM_DUTY_0] = dest[0];
+        bitSet(ledPWMKnown, addr - MPRREG_PWM_DUTY_0);
+      }
+      else
+        dest[0] = 0;
+      return true;
+    }
+  #endif
+  
+  return false;
+}
+
+#if MPR121_FEATURE_GPIO
+// Merges a GPIO data or PWM write into the deferred LED writes.
+void mpr121::deferLEDWrite(mpr121Register addr, byte value) {
+  budget->deferredCount++;
+  
+  if (addr >= MPRREG_PWM_DUTY_0) {
+    byte i = addr - MPRREG_PWM_DUTY_0;
+    ledPWM[i] = value;
+    bitSet(ledPWMKnown, i);
+    bitSet(ledPWMDeferred, i);
+    return;
   }
   
-  return i2cReadBuf;
+  // each GPIO data bit ends up forced to a value, toggled, or unchanged
+  switch (addr) {
+    case MPRREG_GPIO_DATA:
+      ledGPIOForce = 0xff;
+      ledGPIOValue = value;
+      ledGPIOToggle = 0;
+      break;
+    case MPRREG_GPIO_DATA_SET:
+      ledGPIOForce |= value;
+      ledGPIOValue |= value;
+      ledGPIOToggle &= ~value;
+      break;
+    case MPRREG_GPIO_DATA_CLEAR:
+      ledGPIOForce |= value;
+      ledGPIOValue &= ~value;
+      ledGPIOToggle &= ~value;
+      break;
+    default: // MPRREG_GPIO_DATA_TOGGLE
+      ledGPIOValue ^= value & ledGPIOForce;
+      ledGPIOToggle ^= value & ~ledGPIOForce;
+      break;
+  }
 }
 
+// Sends deferred LED writes (PWM first, then GPIO data, the same order the GPIO functions use).
+// If wait is false, gives up (returning false) when the budget can't pay for them yet.
+bool mpr121::flushLEDWrites(bool wait) {
+  while (ledPWMDeferred) {
+    byte first = 0;
+    while (!bitRead(ledPWMDeferred, first))
+      first++;
+    
+    // extend the burst over known registers while there are more deferred ones after them
+    byte last = first;
+    while (last < 3 && bitRead(ledPWMKnown, last + 1) && (ledPWMDeferred >> (last + 1)) != 0)
+      last++;
+    byte span = last - first + 1;
+    
+    unsigned long cost = budget->getTransactionMicros(span, false);
+    if (wait)
+      budget->acquire(MPR_PRIORITY_LED, cost);
+    else if (!budget->take(MPR_PRIORITY_LED, cost))
+      return false;
+    
+    busWrite((mpr121Register)(MPRREG_PWM_DUTY_0 + first), &ledPWM[first], span);
+    ledPWMDeferred &= ~(((1 << span) - 1) << first);
+  }
+  
+  if (ledGPIOForce || ledGPIOToggle) {
+    // set, clear, and toggle are consecutive, and writing 0 to any of them does nothing
+    byte values[3] = { (byte)(ledGPIOForce & ledGPIOValue), (byte)(ledGPIOForce & ~ledGPIOValue), ledGPIOToggle };
+    
+    unsigned long cost = budget->getTransactionMicros(3, false);
+    if (wait)
+      budget->acquire(MPR_PRIORITY_LED, cost);
+    else if (!budget->take(MPR_PRIORITY_LED, cost))
+      return false;
+    
+    busWrite(MPRREG_GPIO_DATA_SET, values, 3);
+    ledGPIOForce = 0;
+    ledGPIOValue = 0;
+    ledGPIOToggle = 0;
+  }
+  
+  return true;
+}
+#endif // MPR121_FEATURE_GPIO
+#endif // MPR121_FEATURE_BUDGET
+
+
+#if MPR121_FEATURE_BATCH
+// Queues a write while batching (replacing any queued write to the same register).
+// Returns false if it has to be sent now instead (anything already queued is sent first).
+bool mpr121::queueWrite(mpr121Register addr, const byte* values, byte count) {
+  bool barrier = count > MPR121_BATCH_LEN; // too big to queue, and already a burst anyway
+  for (byte i = 0; i < count && !barrier; i++) {
+    barrier = isBatchBarrier(addr + i);
+  }
+  
+  if (barrier || batchCount + count > MPR121_BATCH_LEN)
+    flushBatch();
+  if (barrier)
+    return false;
+  
+  for (byte i = 0; i < count; i++) {
+    byte reg = addr + i;
+    
+    byte j = 0;
+    while (j < batchCount && batchRegs[j] != reg)
+      j++;
+    
+    if (j == batchCount) {
+      batchRegs[j] = reg;
+      batchCount++;
+    }
+    batchValues[j] = values[i];
+  }
+  
+  return true;
+}
+
+// Sends queued writes, sorted by register and merged into bursts.
+void mpr121::flushBatch() {
+  // insertion sort (there aren't many entries, and they're often queued nearly in order)
+  for (byte i = 1; i < batchCount; i++) {
+    byte reg = batchRegs[i];
+    byte value = batchValues[i];
+    
+    byte j = i;
+    for ( ; j > 0 && batchRegs[j - 1] > reg; j--) {
+      batchRegs[j] = batchRegs[j - 1];
+      batchValues[j] = batchValues[j - 1];
+    }
+    batchRegs[j] = reg;
+    batchValues[j] = value;
+  }
+  
+  // once sorted, values for consecutive registers are already consecutive in batchValues
+  byte i = 0;
+  while (i < batchCount) {
+    byte first = i;
+    i++;
+    while (i < batchCount && batchRegs[i] == batchRegs[i - 1] + 1 && i - first < MPR121_I2C_BUFLEN - 1)
+      i++;
+    
+    sendWrite((mpr121Register)batchRegs[first], &batchValues[first], i - first);
+  }
+  
+  batchCount = 0;
+}
+
+// Checks if writes to a register can't be queued (because they must stay in order with other writes, or aren't last-write-wins).
+bool mpr121::isBatchBarrier(byte reg) {
+  return reg < MPRREG_ELE0_BASELINE // status (clearing over current)
+      || reg == MPRREG_ELECTRODE_CONFIG // starting or stopping
+      || reg == MPRREG_GPIO_ENABLE // pins are disabled while their mode changes, and that write mustn't be replaced
+      || (reg >= MPRREG_GPIO_DATA_SET && reg <= MPRREG_GPIO_DATA_TOGGLE) // each write changes bits relative to the current data
+      || reg == MPRREG_SOFT_RESET;
+}
+
+// Ends a batch started by beginBatch(), sending queued writes in as few transactions as possible.
+void mpr121::commit() {
+  if (batchDepth == 0)
+    return;
+  
+  batchDepth--;
+  if (batchDepth == 0)
+    flushBatch();
+}
+#endif // MPR121_FEATURE_BATCH
+
+
+#if MPR121_FEATURE_APPLY
+// Records writes to config registers in configImage, or configCapture if set.
+// Returns true if the write was captured and shouldn't be sent.
+bool mpr121::trackConfigWrite(mpr121Register addr, const byte* values, byte count) {
+  byte* image = configCapture ? configCapture : configImage;
+
+  for (byte i = 0; i < count; i++) {
+    byte reg = addr + i;
+    if (reg >= MPRREG_MHD_RISING && reg < MPRREG_MHD_RISING + MPR121_RAW_CONFIG_LEN)
+      image[reg - MPRREG_MHD_RISING] = values[i];
+
+    // keep GPIO data up to date, so the image has the actual output state
+    const byte dataIndex = MPRREG_GPIO_DATA - MPRREG_MHD_RISING;
+    if (reg == MPRREG_GPIO_DATA_SET)
+      image[dataIndex] |= values[i];
+    else if (reg == MPRREG_GPIO_DATA_CLEAR)
+      image[dataIndex] &= ~values[i];
+    else if (reg == MPRREG_GPIO_DATA_TOGGLE)
+      image[dataIndex] ^= values[i];
+  }
+
+  return configCapture != nullptr;
+}
+
+// Sets configImage to power-on register values and marks it invalid (until start() writes all settings).
+void mpr121::resetConfigImage() {
+  memset(configImage, 0, MPR121_RAW_CONFIG_LEN);
+  configImage[MPRREG_AFE_CONFIG - MPRREG_MHD_RISING] = 0x10;
+  configImage[MPRREG_FILTER_CONFIG - MPRREG_MHD_RISING] = 0x24;
+  configImageValid = false;
+}
+
+// Checks if a config register can only be written in stop mode.
+// In run mode, the MPR121 ignores writes to everything except electrode configuration and GPIO registers.
+bool mpr121::requiresStop(byte reg) {
+  if (reg == MPRREG_ELECTRODE_CONFIG)
+    return false;
+  if (reg >= MPRREG_GPIO_CONTROL_0 && reg <= MPRREG_GPIO_DATA_TOGGLE)
+    return false;
+
+  return true;
+}
+#endif // MPR121_FEATURE_APPLY
+
 
 // Checks if an electrode number and count are valid and suitable for use.
 // Returns true if they can be used or false if the caller should immediately return.
@@ -119,6 +544,18 @@ void mpr121::setElectrodeThresholds(byte electrode, byte count, byte touchThresh
   }
 }
 
+// Sets the touch and release thresholds for all electrodes from arrays of 13 values.
+// Uses bursts over the interleaved threshold registers (0x41-0x5A).
+void mpr121::setElectrodeThresholds(const byte* touchThresholds, const byte* releaseThresholds) {
+  byte rawdata[26];
+  for (byte i = 0; i < 13; i++) {
+    rawdata[i*2] = touchThresholds[i];
+    rawdata[i*2 + 1] = releaseThresholds[i];
+  }
+
+  writeRegisters(MPRREG_ELE0_TOUCH_THRESHOLD, rawdata, 26);
+}
+
 
 // Sets the "Max Half Delta" baseline filter values.
 // Max: 63
@@ -150,7 +587,7 @@ void mpr121::setNCL(byte rising, byte falling, byte touched) {
 void mpr121::setFDL(byte rising, byte falling, byte touched) {
   writeRegister(MPRREG_FDL_RISING, rising);
   writeRegister(MPRREG_FDL_FALLING, falling);
-  writeRegister(MPRREG_NCL_TOUCHED, touched);
+  writeRegister(MPRREG_FDL_TOUCHED, touched);
 }
 
 
@@ -184,7 +621,7 @@ void mpr121::setNCLProx(byte rising, byte falling, byte touched) {
 void mpr121::setFDLProx(byte rising, byte falling, byte touched) {
   writeRegister(MPRREG_ELEPROX_FDL_RISING, rising);
   writeRegister(MPRREG_ELEPROX_FDL_FALLING, falling);
-  writeRegister(MPRREG_ELEPROX_NCL_TOUCHED, touched);
+  writeRegister(MPRREG_ELEPROX_FDL_TOUCHED, touched);
 }
 
 
@@ -219,6 +656,10 @@ void mpr121::setFilterConfig(mpr121FilterFFI FFI, byte CDC, mpr121FilterCDT CDT,
   writeRegister(MPRREG_FILTER_GLOBAL_CDC_CONFIG, (FFI_2 << 6) | CDC_6);
   writeRegister(MPRREG_FILTER_GLOBAL_CDT_CONFIG, (CDT_3 << 5) | (SFI_2 << 3) | ESI_3);
 
+  #if MPR121_FEATURE_ANALOG
+    samplePeriodMicros = 1000UL << ESI_3;
+  #endif
+
   // update FFI in autoconf
   byte autoConf = readRegister(MPRREG_AUTOCONFIG_CONTROL_0) & 0b00111111;
   autoConf |= (FFI_2 << 6);
@@ -268,6 +709,7 @@ void mpr121::setAutoConfig(byte USL, byte LSL, byte TL, mpr121AutoConfigRetry RE
 }
 
 
+#if MPR121_FEATURE_GPIO
 // Sets the GPIO PWM value for consecutive pins.
 // (AN3894)
 // 
@@ -282,6 +724,10 @@ void mpr121::setPWM(byte pin, byte count, byte value) {
 
   byte value_4 = value & 0b1111;
   
+  #if MPR121_FEATURE_BATCH
+    beginBatch(); // PWM registers are consecutive, so multiple pins can be sent as one burst
+  #endif
+  
   mpr121Register reg = MPRREG_PWM_DUTY_0;
   byte regVal = 0;
 
@@ -299,39 +745,17 @@ void mpr121::setPWM(byte pin, byte count, byte value) {
     if ((pin + i) % 2 == 1 || i == count - 1) // if the last of a register or the last iteration
       writeRegister(reg, regVal);
   }
+  
+  #if MPR121_FEATURE_BATCH
+    commit();
+  #endif
 }
+#endif // MPR121_FEATURE_GPIO
 
 
-// Creates an MPR121 device with sane default settings.
-// addr:  The I2C address to use. If not specified (or ==0), the next valid address will be chosen automatically.
-//wire:  You can pass in an alternative TwoWire instance.
-mpr121::mpr121(byte addr, TwoWire *wire)
-{
-  static byte usedAddresses = 0;
-  
-  if (addr == 0) {
-    if (!bitRead(usedAddresses, 0)) {
-      addr = 0x5a;
-    }
-    else if (!bitRead(usedAddresses, 1)) {
-      addr = 0x5b;
-    }
-    else if (!bitRead(usedAddresses, 2)) {
-      addr = 0x5c;
-    }
-    else if (!bitRead(usedAddresses, 3)) {
-      addr = 0x5d;
-    }
-    else {
-      addr = 0x5a; // at least fall back to *an* mpr121 if all addresses are taken
-    }
-  }
-  
-  if (addr >= 0x5a && addr <= 0x5d)
-    bitSet(usedAddresses, addr - 0x5a);
-  
-  i2cAddr = addr;
-  i2cWire = wire;
+// Sets all values to sane defaults (the same as a newly created mpr121).
+void mpr121Config::setDefaults() {
+  // (keep MPR121_CONFIG_DEFAULTS in QuickMpr121.h in sync with this)
 
   // values from getting started guide
   // MHDrising = 0x01;
@@ -417,6 +841,155 @@ mpr121::mpr121(byte addr, TwoWire *wire)
   autoConfigInterruptACF = false;
 }
 
+// A quick way to set all touchThresholds and releaseThresholds.
+// prox: Whether to set proximity detection thresholds too.
+void mpr121Config::setAllThresholds(byte touched, byte released, bool prox) {
+  byte maxElectrode = 11;
+  if (prox)
+    maxElectrode = 12;
+
+  for (byte i = 0; i <= maxElectrode; i++) {
+    touchThresholds[i] = touched;
+    releaseThresholds[i] = released;
+  }
+}
+
+
+// Creates an MPR121 device with sane default settings.
+// addr:  The I2C address to use. If not specified (or ==0), the next valid address will be chosen automatically.
+//wire:  You can pass in an alternative TwoWire instance.
+mpr121::mpr121(byte addr, TwoWire *wire)
+{
+  static byte usedAddresses = 0;
+  
+  if (addr == 0) {
+    if (!bitRead(usedAddresses, 0)) {
+      addr = 0x5a;
+    }
+    else if (!bitRead(usedAddresses, 1)) {
+      addr = 0x5b;
+    }
+    else if (!bitRead(usedAddresses, 2)) {
+      addr = 0x5c;
+    }
+    else if (!bitRead(usedAddresses, 3)) {
+      addr = 0x5d;
+    }
+    else {
+      addr = 0x5a; // at least fall back to *an* mpr121 if all addresses are taken
+    }
+  }
+  
+  if (addr >= 0x5a && addr <= 0x5d)
+    bitSet(usedAddresses, addr - 0x5a);
+  
+  i2cAddr = addr;
+  i2cWire = wire;
+  #if MPR121_FEATURE_TRANSPORT
+    transport = nullptr;
+  #endif
+  #if MPR121_FEATURE_BATCH
+    batchDepth = 0;
+    batchCount = 0;
+  #endif
+  #if MPR121_FEATURE_BUDGET
+    budget = nullptr;
+    #if MPR121_FEATURE_GPIO
+      ledPWMKnown = 0;
+      ledPWMDeferred = 0;
+      ledGPIOForce = 0;
+      ledGPIOValue = 0;
+      ledGPIOToggle = 0;
+    #endif
+  #endif
+  #if MPR121_FEATURE_APPLY
+    resetConfigImage();
+    configCapture = nullptr;
+  #endif
+  #if MPR121_FEATURE_ANALOG
+    samplePeriodMicros = 1000;
+    duplicateSamples = 0;
+    droppedSamples = 0;
+    sampleTracking = false;
+  #endif
+
+  #if MPR121_CONFIG_PROFILES
+    config = nullptr;
+    configInProgmem = false;
+  #else
+    setDefaults();
+  #endif
+}
+
+
+// Copies the settings that will be used by start().
+void mpr121::getConfig(mpr121Config &out) {
+  #if MPR121_CONFIG_PROFILES
+    if (!config)
+      out.setDefaults();
+    #ifdef __AVR__
+      else if (configInProgmem)
+        memcpy_P(&out, config, sizeof(mpr121Config));
+    #endif
+    else
+      out = *config;
+  #else
+    out = *this;
+  #endif
+}
+
+
+// Clears auto-configuration enable (ACE) in stop mode, so the next restart keeps baselines and charge settings.
+// This is sent directly, so the config image keeps the configured value (start() sets it again).
+void mpr121::skipAutoConfig() {
+  #if MPR121_FEATURE_BATCH
+    if (batchCount > 0)
+      flushBatch(); // a queued autoconfig write would be sent after this one
+  #endif
+
+  byte acc0 = readRegister(MPRREG_AUTOCONFIG_CONTROL_0);
+  if (bitRead(acc0, 0)) {
+    bitClear(acc0, 0);
+    sendWrite(MPRREG_AUTOCONFIG_CONTROL_0, &acc0, 1);
+  }
+}
+
+// Writes touchThresholds and releaseThresholds for all electrodes.
+// The 26 interleaved registers (0x41-0x5A) are sent in one or two bursts, depending on MPR121_I2C_BUFLEN.
+// The MPR121 ignores threshold writes while running, so if it's running it's stopped just for the writes
+// and restarted with the same electrodes. Auto-configuration is skipped for the restart and calLock modes that load baselines are
+// treated as plain tracking, so baselines and charge settings are kept (start() re-enables auto-configuration if it's configured).
+void mpr121::writeThresholds() {
+  byte oldECR = readRegister(MPRREG_ELECTRODE_CONFIG);
+  bool running = (oldECR & 0b00111111) != 0;
+  if (running)
+    writeRegister(MPRREG_ELECTRODE_CONFIG, oldECR & 0b11000000);
+
+  #if MPR121_CONFIG_PROFILES
+    mpr121Config cfg;
+    getConfig(cfg);
+    setElectrodeThresholds(cfg.touchThresholds, cfg.releaseThresholds);
+  #else
+    setElectrodeThresholds(touchThresholds, releaseThresholds);
+  #endif
+
+  if (running) {
+    skipAutoConfig();
+    writeRegister(MPRREG_ELECTRODE_CONFIG, getRestartECR(oldECR));
+  }
+}
+
+// Reads touch and release thresholds for all electrodes in one burst, into arrays of 13 values.
+void mpr121::readThresholds(byte* touchThresholds, byte* releaseThresholds) {
+  byte rawdata[26];
+  readRegisters(MPRREG_ELE0_TOUCH_THRESHOLD, 26, rawdata);
+
+  for (byte i = 0; i < 13; i++) {
+    touchThresholds[i] = rawdata[i*2];
+    releaseThresholds[i] = rawdata[i*2 + 1];
+  }
+}
+
 
 // Reads one touch state bool.
 // Also use this for reading GPIO inputs.
@@ -531,6 +1104,85 @@ void mpr121::clearOverCurrent() {
 }
   
 
+#if MPR121_FEATURE_ANALOG
+// Reads status, filtered analog data, and baselines for all electrodes into a caller-owned frame.
+// This uses burst reads over the whole 0x00-0x2A register range.
+void mpr121::readFrame(mpr121Frame &frame) {
+  byte rawdata[MPR121_RAW_FRAME_LEN];
+  
+  frame.micros = micros();
+  readRawFrame(rawdata);
+  decodeFrame(rawdata, frame);
+  frame.sample = trackSample(rawdata, frame.micros);
+}
+
+// Updates sample tracking from a raw frame read at microsNow.
+// Returns the estimated chip sample index.
+unsigned long mpr121::trackSample(const byte* rawdata, unsigned long microsNow) {
+  // a Fletcher-style sum (plain and position-weighted byte sums) is plenty to tell consecutive samples apart
+  // the sums are left to wrap instead of being reduced mod 255 for every byte, which is slow on AVR (no hardware divide)
+  unsigned short sum1 = 0, sum2 = 0;
+  for (byte i = 0; i < MPR121_RAW_FRAME_LEN; i++) {
+    sum1 += rawdata[i];
+    sum2 += sum1;
+  }
+  unsigned short checksum = sum2 ^ (sum1 << 8);
+
+  if (!sampleTracking) {
+    sampleTracking = true;
+    sampleIndex = 0;
+    lastSampleMicros = microsNow;
+    lastFrameChecksum = checksum;
+    return sampleIndex;
+  }
+
+  unsigned long elapsed = microsNow - lastSampleMicros; // unsigned subtraction handles micros() overflow
+
+  if (checksum == lastFrameChecksum) {
+    unsigned long passed = elapsed / samplePeriodMicros;
+    if (passed == 0) {
+      duplicateSamples++;
+    }
+    else {
+      // samples were taken, but nothing changed (quiet electrodes)
+      sampleIndex += passed;
+      lastSampleMicros += passed * samplePeriodMicros;
+    }
+  }
+  else {
+    unsigned long passed = (elapsed + samplePeriodMicros / 2) / samplePeriodMicros;
+    if (passed == 0)
+      passed = 1;
+    droppedSamples += passed - 1;
+    sampleIndex += passed;
+    lastSampleMicros = microsNow;
+    lastFrameChecksum = checksum;
+  }
+
+  return sampleIndex;
+}
+
+// Reads the raw status, filtered analog data, and baseline registers (0x00-0x2A) into rawdata.
+// rawdata must have space for MPR121_RAW_FRAME_LEN bytes.
+// Returns a view over rawdata.
+mpr121RawFrame mpr121::readRawFrame(byte* rawdata) {
+  readRegisters(MPRREG_ELE0_TO_ELE7_TOUCH_STATUS, MPR121_RAW_FRAME_LEN, rawdata);
+  return mpr121RawFrame(rawdata);
+}
+
+// Decodes raw registers from readRawFrame into a frame.
+// (frame.micros and frame.sample aren't changed)
+void mpr121::decodeFrame(const byte* rawdata, mpr121Frame &frame) {
+  mpr121RawFrame raw(rawdata);
+  frame.touchState = raw.touchState();
+  frame.oorState = raw.oorState();
+  
+  for (byte i = 0; i < 13; i++) {
+    frame.electrodeData[i] = raw.filtered(i);
+    frame.electrodeBaseline[i] = raw.baseline(i);
+  }
+}
+
 // Reads filtered analog data for consecutive electrodes.
 short* mpr121::readElectrodeData(byte electrode, byte count) {
   if (!checkElectrodeNum(electrode, count))
@@ -559,30 +1211,103 @@ byte* mpr121::readElectrodeBaseline(byte electrode, byte count) {
   return &electrodeBaselineBuf[electrode];
 }
 
+// Reads the difference between filtered analog data and baselines (`filtered - (baseline << 2)`) for consecutive electrodes.
+// If everything from the first electrode's data to the last electrode's baseline fits in MPR121_I2C_BUFLEN (26 - electrode + count bytes),
+// data and baselines are read in one burst, so they're from the same sample.
+// Otherwise, they're read in two bursts (data, then baselines), which may be from different samples.
+short* mpr121::readElectrodeDelta(byte electrode, byte count) {
+  if (!checkElectrodeNum(electrode, count))
+    return electrodeDeltaBuf;
+
+  mpr121Register firstReg = (mpr121Register)(MPRREG_ELE0_FILTERED_DATA_LSB + electrode*2);
+  byte baselineOffset = MPRREG_ELE0_BASELINE + electrode - firstReg;
+  
+  byte rawdata[MPRREG_ELEPROX_BASELINE + 1 - MPRREG_ELE0_FILTERED_DATA_LSB];
+  if (baselineOffset + count <= MPR121_I2C_BUFLEN) {
+    // read everything from the first electrode's data to the last electrode's baseline
+    readRegisters(firstReg, baselineOffset + count, rawdata);
+  }
+  else {
+    // skip the registers between them instead of splitting one long read
+    readRegisters(firstReg, count*2, rawdata);
+    readRegisters((mpr121Register)(MPRREG_ELE0_BASELINE + electrode), count, &rawdata[baselineOffset]);
+  }
+
+  for (byte i = 0; i < count; i++) {
+    short filtered = rawdata[i*2] | ((rawdata[i*2 + 1] & 0b00000011) << 8);
+    electrodeDeltaBuf[electrode + i] = filtered - (rawdata[baselineOffset + i] << 2);
+  }
+
+  return &electrodeDeltaBuf[electrode];
+}
+
 // Write a baseline value to consecutive electrodes.
 void mpr121::writeElectrodeBaseline(byte electrode, byte count, byte value) {
   if (!checkElectrodeNum(electrode, count))
     return;
 
-  for (byte i = 0; i < count; i++) {
-    writeRegister((mpr121Register)(MPRREG_ELE0_BASELINE + (i+electrode)), value);
+  byte values[13];
+  memset(values, value, count);
+  writeRegisters((mpr121Register)(MPRREG_ELE0_BASELINE + electrode), values, count);
+}
+
+// Saves filtered analog data and baselines for all electrodes.
+// Filtered data and baselines (0x1E-0x2A) are read in separate bursts, so they may be from different samples.
+void mpr121::snapshotBaselines(mpr121BaselineSnapshot &snapshot) {
+  byte rawdata[MPRREG_ELEPROX_BASELINE + 1 - MPRREG_ELE0_FILTERED_DATA_LSB];
+  readRegisters(MPRREG_ELE0_FILTERED_DATA_LSB, MPRREG_ELE0_BASELINE - MPRREG_ELE0_FILTERED_DATA_LSB, rawdata);
+  readRegisters(MPRREG_ELE0_BASELINE, 13, &rawdata[MPRREG_ELE0_BASELINE - MPRREG_ELE0_FILTERED_DATA_LSB]);
+
+  for (byte i = 0; i < 13; i++) {
+    snapshot.electrodeData[i] = rawdata[i*2] | ((rawdata[i*2 + 1] & 0b00000011) << 8);
+    snapshot.electrodeBaseline[i] = rawdata[MPRREG_ELE0_BASELINE - MPRREG_ELE0_FILTERED_DATA_LSB + i];
   }
 }
 
-// A quick way to set all touchThresholds and releaseThresholds.
-// prox: Whether to set proximity detection thresholds too.
-void mpr121::setAllThresholds(byte touched, byte released, bool prox) {
-  byte maxElectrode = 11;
-  if (prox)
-    maxElectrode = 12;
+// Writes baselines from a snapshot back to the electrodes in mask (bit 0 is ELE0, bit 12 is ELEPROX) in one burst.
+// If mask has gaps, current baselines for the gaps are read first (also in one burst) so they can be written back unchanged.
+// Baselines can only be written in stop mode, so if the MPR121 is running, it's stopped briefly and restarted with the same electrodes
+// (without auto-configuration, which would replace the restored baselines or change charge settings).
+void mpr121::restoreBaselines(const mpr121BaselineSnapshot &snapshot, short mask) {
+  mask &= 0x1fff;
+  if (mask == 0)
+    return;
 
-  for (byte i = 0; i <= maxElectrode; i++) {
-    touchThresholds[i] = touched;
-    releaseThresholds[i] = released;
+  byte first = 0;
+  while (!bitRead(mask, first))
+    first++;
+  byte last = 12;
+  while (!bitRead(mask, last))
+    last--;
+  byte count = last - first + 1;
+
+  // stopping first also means tracking can't change the gaps between reading and writing them
+  byte oldECR = readRegister(MPRREG_ELECTRODE_CONFIG);
+  bool running = (oldECR & 0b00111111) != 0;
+  if (running)
+    writeRegister(MPRREG_ELECTRODE_CONFIG, oldECR & 0b11000000);
+
+  byte rawdata[13];
+  short rangeMask = ((1 << count) - 1) << first;
+  if (mask != rangeMask)
+    readRegisters((mpr121Register)(MPRREG_ELE0_BASELINE + first), count, rawdata);
+
+  for (byte i = 0; i < count; i++) {
+    if (bitRead(mask, first + i))
+      rawdata[i] = snapshot.electrodeBaseline[first + i];
+  }
+
+  writeRegisters((mpr121Register)(MPRREG_ELE0_BASELINE + first), rawdata, count);
+
+  if (running) {
+    skipAutoConfig();
+    writeRegister(MPRREG_ELECTRODE_CONFIG, getRestartECR(oldECR));
   }
 }
+#endif // MPR121_FEATURE_ANALOG
 
 
+#if MPR121_FEATURE_CHARGE
 // Reads per-electrode "Charge Discharge Current" (μA) for consecutive electrodes.
 // Max: 63
 byte* mpr121::readElectrodeCDC(byte electrode, byte count) {
@@ -656,6 +1381,36 @@ void mpr121::writeElectrodeCDT(byte electrode, byte count, mpr121FilterCDT value
 }
 
 
+// Reads CDC and CDT for all electrodes in one burst.
+void mpr121::readChargeConfig(mpr121ChargeConfig &config) {
+  byte rawdata[MPR121_RAW_CHARGE_LEN];
+  readRegisters(MPRREG_ELE0_CDC, MPR121_RAW_CHARGE_LEN, rawdata);
+
+  for (byte i = 0; i < 13; i++) {
+    config.CDC[i] = rawdata[i] & 0b00111111;
+    config.CDT[i] = (mpr121FilterCDT)(( rawdata[13 + i/2] >> (i % 2 == 0 ? 0 : 4) ) & 0b111);
+  }
+}
+
+// Writes CDC and CDT for all electrodes in one burst (CDT values are packed locally, so nothing needs to be read first).
+void mpr121::writeChargeConfig(const mpr121ChargeConfig &config) {
+  byte rawdata[MPR121_RAW_CHARGE_LEN];
+
+  for (byte i = 0; i < 13; i++) {
+    rawdata[i] = config.CDC[i] & 0b00111111;
+  }
+  for (byte i = 0; i < 7; i++) {
+    rawdata[13 + i] = config.CDT[i*2] & 0b111;
+    if (i*2 + 1 < 13)
+      rawdata[13 + i] |= (config.CDT[i*2 + 1] & 0b111) << 4;
+  }
+
+  writeRegisters(MPRREG_ELE0_CDC, rawdata, MPR121_RAW_CHARGE_LEN);
+}
+#endif // MPR121_FEATURE_CHARGE
+
+
+#if MPR121_FEATURE_GPIO
 // Sets pin mode for consecutive GPIO pins.
 // GPIO can be used on pins 4-11 when they aren't used for sensing.
 // Use mode MPR_GPIO_MODE_OUTPUT_OPENDRAIN_HIGH for direct LED driving -- it can source up to 12mA.
@@ -665,6 +1420,9 @@ void mpr121::setGPIOMode(byte pin, byte count, mpr121GPIOMode mode) {
 
   pin -= 4; // easier to make it 0-indexed now
 
+  #if MPR121_FEATURE_BATCH
+    beginBatch(); // control 0 and 1 are consecutive, so they can be sent as one burst (enable writes are sent in order)
+  #endif
   
   byte enableByte = readRegister(MPRREG_GPIO_ENABLE);
 
@@ -674,8 +1432,12 @@ void mpr121::setGPIOMode(byte pin, byte count, mpr121GPIOMode mode) {
   }
   writeRegister(MPRREG_GPIO_ENABLE, enableByte);
 
-  if (mode == MPR_GPIO_MODE_DISABLED)
+  if (mode == MPR_GPIO_MODE_DISABLED) {
+    #if MPR121_FEATURE_BATCH
+      commit();
+    #endif
     return; // all done, no need to worry about other values
+  }
 
 
   byte tempByte;
@@ -712,6 +1474,10 @@ void mpr121::setGPIOMode(byte pin, byte count, mpr121GPIOMode mode) {
     bitWrite(enableByte, pin + i, tempVal);
   }
   writeRegister(MPRREG_GPIO_ENABLE, enableByte);
+
+  #if MPR121_FEATURE_BATCH
+    commit();
+  #endif
 }
 
 
@@ -760,6 +1526,7 @@ void mpr121::writeGPIOAnalog(byte pin, byte count, byte value) {
   }
   writeRegister(reg, tempByte);
 }
+#endif // MPR121_FEATURE_GPIO
 
 
 // Optional alternative to using Wire.begin() and Wire.setClock().
@@ -774,63 +1541,163 @@ void mpr121::begin(unsigned long clock) {
 }
 
 
-// Applies settings and enters run mode with a given number of electrodes.
-// Very much based on the quick start guide (AN3944).
-void mpr121::start(byte electrodes) {
-  stop();
-  
+// Writes all settings (except electrode configuration) from cfg.
+// Values with less than 8 bits are masked in cfg, and autoconfig limits are calculated if not set.
+void mpr121::writeConfig(mpr121Config &cfg) {
   // restrict value of numeric properties with < 8 bits to actual sent values
-  MHDrising &= 0b00111111;
-  MHDfalling &= 0b00111111;
-  NHDrising &= 0b00111111;
-  NHDfalling &= 0b00111111;
-  NHDtouched &= 0b00111111;
-  MHDrisingProx &= 0b00111111;
-  MHDfallingProx &= 0b00111111;
-  NHDrisingProx &= 0b00111111;
-  NHDfallingProx &= 0b00111111;
-  NHDtouchedProx &= 0b00111111;
-  debounceTouch &= 0b0111;
-  debounceRelease &= 0b0111;
-  globalCDC &= 0b00111111;
+  cfg.MHDrising &= 0b00111111;
+  cfg.MHDfalling &= 0b00111111;
+  cfg.NHDrising &= 0b00111111;
+  cfg.NHDfalling &= 0b00111111;
+  cfg.NHDtouched &= 0b00111111;
+  cfg.MHDrisingProx &= 0b00111111;
+  cfg.MHDfallingProx &= 0b00111111;
+  cfg.NHDrisingProx &= 0b00111111;
+  cfg.NHDfallingProx &= 0b00111111;
+  cfg.NHDtouchedProx &= 0b00111111;
+  cfg.debounceTouch &= 0b0111;
+  cfg.debounceRelease &= 0b0111;
+  cfg.globalCDC &= 0b00111111;
 
   // set/calculate autoconfig values
-  if (autoConfigUSL == 0)
-    autoConfigUSL = 156;
-  if (autoConfigLSL == 0)
-    autoConfigLSL = autoConfigUSL * 0.65;
-  if (autoConfigTL == 0)
-    autoConfigTL = autoConfigUSL * 0.9;
-
-  setMHD(MHDrising, MHDfalling);
-  setNHD(NHDrising, NHDfalling, NHDtouched);
-  setNCL(NCLrising, NCLfalling, NCLtouched);
-  setFDL(FDLrising, FDLfalling, FDLtouched);
-  
-  setMHDProx(MHDrisingProx, MHDfallingProx);
-  setNHDProx(NHDrisingProx, NHDfallingProx, NHDtouchedProx);
-  setNCLProx(NCLrisingProx, NCLfallingProx, NCLtouchedProx);
-  setFDLProx(FDLrisingProx, FDLfallingProx, FDLtouchedProx);
+  if (cfg.autoConfigUSL == 0)
+    cfg.autoConfigUSL = 156;
+  if (cfg.autoConfigLSL == 0)
+    cfg.autoConfigLSL = cfg.autoConfigUSL * 65 / 100; // integer math avoids pulling in float support
+  if (cfg.autoConfigTL == 0)
+    cfg.autoConfigTL = cfg.autoConfigUSL * 9 / 10;
+
+  #if MPR121_FEATURE_BATCH
+    beginBatch(); // most of these registers are consecutive, so they can be sent as a few bursts
+  #endif
+
+  setMHD(cfg.MHDrising, cfg.MHDfalling);
+  setNHD(cfg.NHDrising, cfg.NHDfalling, cfg.NHDtouched);
+  setNCL(cfg.NCLrising, cfg.NCLfalling, cfg.NCLtouched);
+  setFDL(cfg.FDLrising, cfg.FDLfalling, cfg.FDLtouched);
   
-  for (byte i = 0; i < 13; i++)
-  {
-    mpr121::setElectrodeThresholds(i, touchThresholds[i], releaseThresholds[i]);
-  }
+  setMHDProx(cfg.MHDrisingProx, cfg.MHDfallingProx);
+  setNHDProx(cfg.NHDrisingProx, cfg.NHDfallingProx, cfg.NHDtouchedProx);
+  setNCLProx(cfg.NCLrisingProx, cfg.NCLfallingProx, cfg.NCLtouchedProx);
+  setFDLProx(cfg.FDLrisingProx, cfg.FDLfallingProx, cfg.FDLtouchedProx);
+  
+  setElectrodeThresholds(cfg.touchThresholds, cfg.releaseThresholds);
+
+  setDebounce(cfg.debounceTouch, cfg.debounceRelease);
+
+  setFilterConfig(cfg.FFI, cfg.globalCDC, cfg.globalCDT, cfg.SFI, cfg.ESI);
+
+  setAutoConfig(cfg.autoConfigUSL, cfg.autoConfigLSL, cfg.autoConfigTL, cfg.autoConfigRetry, cfg.autoConfigBaselineAdjust, cfg.autoConfigEnableReconfig, cfg.autoConfigEnableCalibration,
+                cfg.autoConfigSkipChargeTime, cfg.autoConfigInterruptOOR, cfg.autoConfigInterruptARF, cfg.autoConfigInterruptACF);
+
+  #if MPR121_FEATURE_BATCH
+    commit();
+  #endif
+
+  #if MPR121_FEATURE_APPLY
+    if (!configCapture)
+      configImageValid = true;
+  #endif
+}
 
-  setDebounce(debounceTouch, debounceRelease);
 
-  setFilterConfig(FFI, globalCDC, globalCDT, SFI, ESI);
+// Applies settings and enters run mode with a given number of electrodes.
+// Very much based on the quick start guide (AN3944).
+void mpr121::start(byte electrodes) {
+  stop();
+  
+  #if MPR121_CONFIG_PROFILES
+    mpr121Config cfgCopy;
+    getConfig(cfgCopy);
+    mpr121Config &cfg = cfgCopy;
+  #else
+    mpr121Config &cfg = *this;
+  #endif
 
-  setAutoConfig(autoConfigUSL, autoConfigLSL, autoConfigTL, autoConfigRetry, autoConfigBaselineAdjust, autoConfigEnableReconfig, autoConfigEnableCalibration,
-                autoConfigSkipChargeTime, autoConfigInterruptOOR, autoConfigInterruptARF, autoConfigInterruptACF);
+  writeConfig(cfg);
+
+  #if MPR121_FEATURE_ANALOG
+    sampleTracking = false; // sampling restarts
+  #endif
 
   // OVCF blocks starting, so reset it 
   if (readOverCurrent())
     clearOverCurrent();
   
-  setElectrodeConfiguration(calLock, proxEnable, electrodes);
+  setElectrodeConfiguration(cfg.calLock, cfg.proxEnable, electrodes);
 }
 
+#if MPR121_FEATURE_APPLY
+// Applies changed settings without restarting.
+// Only changed registers are written, and run mode is only left if a changed register requires it.
+void mpr121::apply() {
+  #if MPR121_CONFIG_PROFILES
+    mpr121Config cfgCopy;
+    getConfig(cfgCopy);
+    mpr121Config &cfg = cfgCopy;
+  #else
+    mpr121Config &cfg = *this;
+  #endif
+
+  const byte ecrIndex = MPRREG_ELECTRODE_CONFIG - MPRREG_MHD_RISING;
+  byte oldECR = configImageValid ? configImage[ecrIndex] : readRegister(MPRREG_ELECTRODE_CONFIG);
+  bool running = (oldECR & 0b00111111) != 0;
+  mpr121ElectrodeConfigProx ELEPROX_EN = running ? cfg.proxEnable : MPR_ELEPROX_DISABLED;
+  byte ELE_EN = running ? oldECR & 0b00001111 : 0;
+
+  if (!configImageValid) {
+    // nothing to compare against, so write everything
+    if (running)
+      writeRegister(MPRREG_ELECTRODE_CONFIG, oldECR & 0b11000000);
+    writeConfig(cfg);
+    setElectrodeConfiguration(cfg.calLock, ELEPROX_EN, ELE_EN);
+    return;
+  }
+
+  // build the new register image without sending anything
+  byte image[MPR121_RAW_CONFIG_LEN];
+  memcpy(image, configImage, MPR121_RAW_CONFIG_LEN);
+  configCapture = image;
+  writeConfig(cfg);
+  setElectrodeConfiguration(cfg.calLock, ELEPROX_EN, ELE_EN);
+  configCapture = nullptr;
+
+  bool needStop = false;
+  for (byte i = 0; i < MPR121_RAW_CONFIG_LEN; i++) {
+    if (image[i] != configImage[i] && requiresStop(MPRREG_MHD_RISING + i))
+      needStop = running;
+  }
+
+  if (needStop)
+    writeRegister(MPRREG_ELECTRODE_CONFIG, oldECR & 0b11000000);
+
+  // write changed registers (except electrode config), combining consecutive ones into bursts
+  byte i = 0;
+  while (i < MPR121_RAW_CONFIG_LEN) {
+    if (i == ecrIndex || image[i] == configImage[i]) {
+      i++;
+      continue;
+    }
+
+    byte first = i;
+    while (i < MPR121_RAW_CONFIG_LEN && i != ecrIndex && image[i] != configImage[i])
+      i++;
+
+    writeRegisters((mpr121Register)(MPRREG_MHD_RISING + first), &image[first], i - first);
+  }
+
+  // electrode config goes last, so it restarts with everything else already set
+  // (load modes of calLock only matter when starting, so they aren't counted as changes and don't reload baselines when restarting)
+  if (needStop) {
+    skipAutoConfig();
+    writeRegister(MPRREG_ELECTRODE_CONFIG, getRestartECR(image[ecrIndex]));
+  }
+  else if (getRestartECR(image[ecrIndex]) != getRestartECR(configImage[ecrIndex]))
+    writeRegister(MPRREG_ELECTRODE_CONFIG, image[ecrIndex]);
+}
+#endif // MPR121_FEATURE_APPLY
+
+
 // Exits run mode.
 void mpr121::stop() {
   byte oldConfig = readRegister(MPRREG_ELECTRODE_CONFIG);
@@ -847,5 +1714,12 @@ bool mpr121::checkRunning() {
 // Resets the MPR121.
 void mpr121::softReset() {
   writeRegister(MPRREG_SOFT_RESET, 0x63);
+
+  #if MPR121_FEATURE_APPLY
+    resetConfigImage();
+  #endif
+  #if MPR121_FEATURE_BUDGET && MPR121_FEATURE_GPIO
+    ledPWMKnown = 0;
+  #endif
 }
 
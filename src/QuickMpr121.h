@@ -13,11 +13,17 @@
  * 
  * \section notes Important notes
  * Reading data isn't thread-safe, but that shouldn't be an issue for most use cases.
+ * On Linux, mpr121Reader (QuickMpr121Reader.h) can run a background thread per bus that owns all I2C traffic and publishes the latest mpr121Frame for each device to any number of threads.
  * 
  * Also note that some result buffers (returned by some functions) are shared between instances to save memory.
  * Process or save data for one mpr121 before reading data from the next (or change the MPR121_SAVE_MEMORY define to false to avoid this).
  * 
- * Changes to properties won't take effect until you restart the MPR121.
+ * Changes to properties won't take effect until you restart the MPR121 (or call mpr121::apply()).
+ * 
+ * If you're using lots of MPR121s on an MCU with little RAM, change the MPR121_CONFIG_PROFILES define to true.
+ * Settings then live in mpr121Config profiles that can be shared between identical devices.
+ * 
+ * Unused features can be removed to save flash by setting the MPR121_FEATURE_* defines to false.
  * 
  * 
  * AN**** numbers in docs/comments refer to application notes, available on the NXP website.
@@ -46,6 +52,65 @@
 // make some buffers static (shared between instances) to save memory
 #define MPR121_SAVE_MEMORY true
 
+// store settings in shared mpr121Config profiles (set with mpr121::setConfig) instead of in each mpr121
+// this saves about 65 bytes of RAM per mpr121 (settings are a pointer and a flag instead of a full mpr121Config),
+// but settings can't be changed through mpr121 properties
+// bus budgets and batching (which need RAM in each mpr121) are also off by default with profiles
+#define MPR121_CONFIG_PROFILES false
+
+// feature selection -- set any of these to false to remove that feature and save flash/RAM (useful for small MCUs), or true to add opt-in features
+// touch state reads and start/stop are always available
+// (see extras/SizeReport for flash/RAM usage of different combinations)
+#ifndef MPR121_FEATURE_ANALOG
+#define MPR121_FEATURE_ANALOG true // filtered data, baseline, delta, and frame reads, and baseline writes
+#endif
+#ifndef MPR121_FEATURE_CHARGE
+#define MPR121_FEATURE_CHARGE true // per-electrode CDC/CDT reads and writes
+#endif
+#ifndef MPR121_FEATURE_GPIO
+#define MPR121_FEATURE_GPIO true // GPIO and PWM
+#endif
+#ifndef MPR121_FEATURE_TRANSPORT
+#define MPR121_FEATURE_TRANSPORT true // mpr121::setTransport (alternative register access)
+#endif
+#ifndef MPR121_FEATURE_APPLY
+#define MPR121_FEATURE_APPLY false // mpr121::apply and mpr121ResetMonitor (live reconfiguration, opt-in because it uses about 90 bytes of RAM per mpr121)
+#endif
+#ifndef MPR121_FEATURE_BUDGET
+#define MPR121_FEATURE_BUDGET !MPR121_CONFIG_PROFILES // mpr121BusBudget and mpr121::setBusBudget (bus bandwidth limiting, uses about 10 bytes of RAM per mpr121)
+#endif
+#ifndef MPR121_FEATURE_BATCH
+#define MPR121_FEATURE_BATCH !MPR121_CONFIG_PROFILES // mpr121::beginBatch/commit (write combining, uses 2 * MPR121_BATCH_LEN + 2 bytes of RAM per mpr121)
+#endif
+
+#ifndef MPR121_BATCH_LEN
+#define MPR121_BATCH_LEN 16 // max register writes queued by a batch before they're sent early
+#endif
+
+// enable the background reader thread (mpr121Reader, see QuickMpr121Reader.h)
+// only available on Linux hosts with an Arduino-compatible Wire implementation
+#ifdef __linux__
+  #define MPR121_READER_THREAD MPR121_FEATURE_ANALOG
+#else
+  #define MPR121_READER_THREAD false
+#endif
+
+// enable replaying recordings from mmap-ed files (mpr121ReplayFile, see QuickMpr121Recorder.h)
+// only available on Linux hosts
+#ifdef __linux__
+  #define MPR121_REPLAY (MPR121_FEATURE_ANALOG && MPR121_FEATURE_TRANSPORT)
+#else
+  #define MPR121_REPLAY false
+#endif
+
+// probe separate buses from parallel threads in mpr121Discovery (see QuickMpr121Discover.h)
+// only available on Linux hosts
+#ifdef __linux__
+  #define MPR121_DISCOVER_THREADS true
+#else
+  #define MPR121_DISCOVER_THREADS false
+#endif
+
 
 // define DEPRECATED so the same syntax can be used for any compiler without issues
 #if __GNUC__
@@ -85,31 +150,325 @@
 #define MPR_LED7 MPR_ELE11
 
 
+/**
+ * A decoded snapshot of the MPR121 status and data registers (0x00-0x2A).
+ * 
+ * Unlike the buffers returned by individual read functions, frames are owned by the caller.
+ */
+struct mpr121Frame {
+  unsigned long micros; ///< Host micros() timestamp taken just before reading
+  unsigned long sample; ///< Estimated chip sample index (see mpr121::readFrame)
+  short touchState; ///< The 13 touch state bits (same as readTouchState())
+  short oorState; ///< The 15 out of range bits (same as readOORState())
+  short electrodeData[13]; ///< Filtered analog data for ELE0-ELE11 and ELEPROX
+  byte electrodeBaseline[13]; ///< Baseline values for ELE0-ELE11 and ELEPROX
+};
+
+/// Number of registers in a raw frame (0x00-0x2A: status, filtered data, and baselines)
+#define MPR121_RAW_FRAME_LEN 43
+
+/**
+ * A view over a raw frame (registers 0x00-0x2A, as read by mpr121::readRawFrame()) that decodes values as they're accessed.
+ *
+ * Nothing is copied -- the view just points at the caller's bytes (a buffer, a ring buffer slot, an mpr121Record, etc.), which must outlive it.
+ * Raw frames are smaller than mpr121Frame, and only the values that are actually used get decoded.
+ */
+struct mpr121RawFrame {
+  const byte* regs; ///< The MPR121_RAW_FRAME_LEN raw bytes
+
+  /**
+   * Creates a view over MPR121_RAW_FRAME_LEN raw bytes.
+   */
+  mpr121RawFrame(const byte* regs) : regs(regs) {}
+
+  /**
+   * Gets the 13 touch state bits (same as mpr121Frame::touchState).
+   */
+  short touchState() const {
+    return regs[0] | ((regs[1] & 0b00011111) << 8);
+  }
+
+  /**
+   * Gets the 15 out of range bits (same as mpr121Frame::oorState).
+   */
+  short oorState() const {
+    byte autoConfBits = ((regs[3] & 0b10000000) >> 2) | (regs[3] & 0b01000000);
+    return regs[2] | ((regs[3] & 0b00011111) << 8) | (autoConfBits << 8);
+  }
+
+  /**
+   * Checks if an electrode is touched (0-12).
+   */
+  bool touched(byte electrode) const {
+    return (regs[electrode >> 3] >> (electrode & 7)) & 1;
+  }
+
+  /**
+   * Checks if an electrode is out of range (0-12), or auto-configuration (13) or auto-reconfiguration (14) failed.
+   */
+  bool oor(byte bit) const {
+    return (oorState() >> bit) & 1;
+  }
+
+  /**
+   * Gets filtered analog data for an electrode (0-12).
+   */
+  short filtered(byte electrode) const {
+    return regs[MPRREG_ELE0_FILTERED_DATA_LSB + electrode*2] | ((regs[MPRREG_ELE0_FILTERED_DATA_MSB + electrode*2] & 0b00000011) << 8);
+  }
+
+  /**
+   * Gets the baseline value for an electrode (0-12).
+   */
+  byte baseline(byte electrode) const {
+    return regs[MPRREG_ELE0_BASELINE + electrode];
+  }
+
+  /**
+   * Gets the delta (filtered data - baseline) for an electrode (0-12), same as mpr121::readElectrodeDelta().
+   */
+  short delta(byte electrode) const {
+    return filtered(electrode) - (baseline(electrode) << 2);
+  }
+};
+
+#if MPR121_FEATURE_ANALOG
+  /**
+   * Baselines saved by mpr121::snapshotBaselines, for restoring later with mpr121::restoreBaselines.
+   */
+  struct mpr121BaselineSnapshot {
+    short electrodeData[13]; ///< Filtered analog data for ELE0-ELE11 and ELEPROX when the snapshot was taken
+    byte electrodeBaseline[13]; ///< Baseline values for ELE0-ELE11 and ELEPROX
+  };
+#endif
+
+/// Number of registers in a raw configuration image (0x2B-0x7F: everything written by mpr121::start())
+#define MPR121_RAW_CONFIG_LEN 85
+
+#if MPR121_FEATURE_CHARGE
+  /**
+   * Per-electrode charge settings for all electrodes (see mpr121::readChargeConfig and mpr121::writeChargeConfig).
+   * 
+   * After auto-configuration, these are the values it chose.
+   */
+  struct mpr121ChargeConfig {
+    byte CDC[13]; ///< "Charge Discharge Current" (μA) for ELE0-ELE11 and ELEPROX (max 63, 0 to use the global CDC)
+    mpr121FilterCDT CDT[13]; ///< "Charge Discharge Time" (μs) for ELE0-ELE11 and ELEPROX (MPR_CDT_DISABLED to use the global CDT)
+  };
+#endif
+
+/// Number of registers holding per-electrode charge settings (0x5F-0x72: 13 CDC, then 7 packed CDT)
+#define MPR121_RAW_CHARGE_LEN 20
+
+
+/**
+ * Alternative register access for an mpr121 (set using mpr121::setTransport).
+ * 
+ * Implement this to route I2C traffic somewhere other than a TwoWire instance -- for example, replaying recorded data.
+ */
+class mpr121Transport {
+public:
+  virtual ~mpr121Transport() {}
+
+  /**
+   * Writes values to consecutive registers of the MPR121 at an I2C address.
+   */
+  virtual void write(byte i2cAddr, mpr121Register addr, const byte* values, byte count) = 0;
+
+  /**
+   * Reads values from consecutive registers of the MPR121 at an I2C address into dest.
+   * Returns the number of bytes actually read.
+   */
+  virtual byte read(byte i2cAddr, mpr121Register addr, byte* dest, byte count) = 0;
+};
+
+/**
+ * Settings applied by mpr121::start().
+ * 
+ * Normally these are just properties of each mpr121.
+ * If MPR121_CONFIG_PROFILES is true, they're stored separately so identical devices can share one profile (see mpr121::setConfig).
+ */
+struct mpr121Config {
+  byte touchThresholds[13]; ///< Touch detection thresholds for ELE0-ELE11 and ELEPROX
+  byte releaseThresholds[13]; ///< Release detection thresholds for ELE0-ELE11 and ELEPROX
+
+  byte MHDrising; ///< "Max Half Delta" rising baseline adjustment value (AN3891) -- max: 63
+  byte MHDfalling; ///< "Max Half Delta" falling baseline adjustment value (AN3891) -- max: 63
+  
+  byte NHDrising; ///< "Noise Half Delta" rising baseline adjustment value (AN3891) -- max: 63
+  byte NHDfalling; ///< "Noise Half Delta" falling baseline adjustment value (AN3891) -- max: 63
+  byte NHDtouched; ///< "Noise Half Delta" touched baseline adjustment value (AN3891) -- max: 63
+  
+  byte NCLrising; ///< "Noise Count Limit" rising baseline adjustment value (AN3891)
+  byte NCLfalling; ///< "Noise Count Limit" falling baseline adjustment value (AN3891)
+  byte NCLtouched; ///< "Noise Count Limit" touched baseline adjustment value (AN3891)
+  
+  byte FDLrising; ///< "Filter Delay Limit" rising baseline adjustment value (AN3891)
+  byte FDLfalling; ///< "Filter Delay Limit" falling baseline adjustment value (AN3891)
+  byte FDLtouched; ///< "Filter Delay Limit" touched baseline adjustment value (AN3891)
+
+  
+  byte MHDrisingProx; ///< "Max Half Delta" rising value for proximity detection (AN3891/AN3893) -- max: 63
+  byte MHDfallingProx; ///< "Max Half Delta" falling value for proximity detection (AN3891/AN3893) -- max: 63
+  
+  byte NHDrisingProx; ///< "Noise Half Delta" rising value for proximity detection (AN3891/AN3893) -- max: 63
+  byte NHDfallingProx; ///< "Noise Half Delta" falling value for proximity detection (AN3891/AN3893) -- max: 63
+  byte NHDtouchedProx; ///< "Noise Half Delta" touched value for proximity detection (AN3891/AN3893) -- max: 63
+  
+  byte NCLrisingProx; ///< "Noise Count Limit" rising value for proximity detection (AN3891/AN3893)
+  byte NCLfallingProx; ///< "Noise Count Limit" falling value for proximity detection (AN3891/AN3893)
+  byte NCLtouchedProx; ///< "Noise Count Limit" touched value for proximity detection (AN3891/AN3893)
+  
+  byte FDLrisingProx; ///< "Filter Delay Limit" rising value for proximity detection (AN3891/AN3893)
+  byte FDLfallingProx; ///< "Filter Delay Limit" falling value for proximity detection (AN3891/AN3893)
+  byte FDLtouchedProx; ///< "Filter Delay Limit" touched value for proximity detection (AN3891/AN3893)
+
+
+  byte debounceTouch; ///< Set "Debounce" count for touches (times a detection must be sampled) -- max: 7
+  byte debounceRelease; ///< Set "Debounce" count for releases (times a detection must be sampled) -- max: 7
+
+
+  mpr121FilterFFI FFI; ///< "First Filter Iterations" (number of samples taken for the first level of filtering)
+  byte globalCDC; ///< Global "Charge Discharge Current" (μA), not used if autoconfig is enabled -- max 63
+  mpr121FilterCDT globalCDT; ///< Global "Charge Discharge Time" (μs), not used if autoconfig is enabled
+  mpr121FilterSFI SFI; ///< "Second Filter Iterations" (number of samples taken for the second level of filtering)
+  mpr121FilterESI ESI; ///< "Electrode Sample Interval" (ms)
+
+
+  mpr121ElectrodeConfigCL calLock; ///< "Calibration Lock" (baseline tracking and initial value settings)
+  mpr121ElectrodeConfigProx proxEnable; ///< ELEPROX_EN: sets what electrodes will be used for proximity detection
+
+  byte autoConfigUSL; ///< "Up-Side Limit" for auto calibration -- if not set when starting, this will be automatically set to the ideal value for 1.8V supply
+  byte autoConfigLSL; ///< "Low-Side Limit" for auto calibration -- if not set when starting, this will be automatically set based on USL
+  byte autoConfigTL; ///< "Target Level" for auto calibration -- if not set when starting, this will be automatically set based on USL
+  mpr121AutoConfigRetry autoConfigRetry; ///< Number of retries for failed auto-config before out of range will be set
+  mpr121AutoConfigBVA autoConfigBaselineAdjust; ///< "Baseline Value Adjust" changes how the baseline registers will be set after auto-configuration completes
+  bool autoConfigEnableReconfig; ///< "Automatic Reconfiguration Enable" will try to reconfigure out of range (failed) channels every sampling interval
+  bool autoConfigEnableCalibration; ///< "Automatic Configuration Enable" will enable/disable auto-configuration when entering run mode
+  
+  bool autoConfigSkipChargeTime; ///< "Skip Charge Time Search" will skip searching for charge time and use the already-set per-electrode or global value
+                                 ///< 
+                                 ///< This results in a shorter time to configure, but the designer must supply appropriate values.
+  bool autoConfigInterruptOOR; ///< "Out-of-range interrupt enable" will trigger an interrupt when a channel is determined to be out of range
+  bool autoConfigInterruptARF; ///< "Auto-reconfiguration fail interrupt enable" will trigger an interrupt when auto-reconfiguration fails
+  bool autoConfigInterruptACF; ///< "Auto-configuration fail interrupt enable" will trigger an interrupt when auto-configuration fails
+
+
+  /**
+   * Sets all values to sane defaults (the same as a newly created mpr121).
+   */
+  void setDefaults();
+
+  /**
+   * A quick way to set all ::touchThresholds and ::releaseThresholds.
+   * 
+   * \param prox  Whether to set proximity detection thresholds too.
+   */
+  void setAllThresholds(byte touched, byte released, bool prox);
+};
+
+/**
+ * Initializer for mpr121Config::touchThresholds and mpr121Config::releaseThresholds with the same value for every electrode (including ELEPROX).
+ */
+#define MPR121_CONFIG_THRESHOLDS(touched, released) \
+  { touched, touched, touched, touched, touched, touched, touched, touched, touched, touched, touched, touched, touched }, \
+  { released, released, released, released, released, released, released, released, released, released, released, released, released }
+
+/**
+ * Initializer for an mpr121Config with the same values as mpr121Config::setDefaults().
+ * Use this for profiles that must be set up at compile time, like PROGMEM profiles for mpr121::setConfig_P (`const mpr121Config profile PROGMEM = MPR121_CONFIG_DEFAULTS;`).
+ * 
+ * Values are in the same order as the members of mpr121Config, so a customized profile can be written by copying this and changing values
+ * (see the ConfigProfiles example).
+ */
+#define MPR121_CONFIG_DEFAULTS { \
+  MPR121_CONFIG_THRESHOLDS(0x0f, 0x0a), \
+  0x01, 0x01, /* MHD rising, falling */ \
+  0x01, 0x03, 0x00, /* NHD rising, falling, touched */ \
+  0x04, 0xc0, 0x00, /* NCL rising, falling, touched */ \
+  0x00, 0x02, 0x00, /* FDL rising, falling, touched */ \
+  0x20, 0x01, /* proximity MHD rising, falling */ \
+  0x10, 0x03, 0x00, /* proximity NHD rising, falling, touched */ \
+  0x04, 0xc0, 0x00, /* proximity NCL rising, falling, touched */ \
+  0x00, 0x80, 0x00, /* proximity FDL rising, falling, touched */ \
+  0x00, 0x00, /* debounce touch, release */ \
+  MPR_FFI_6, 16, MPR_CDT_0_5, MPR_SFI_4, MPR_ESI_1, \
+  MPR_CL_TRACKING_ENABLED, MPR_ELEPROX_DISABLED, \
+  0, 0, 0, /* auto-config USL, LSL, TL */ \
+  MPR_AUTOCONFIG_RETRY_DISABLED, MPR_AUTOCONFIG_BVA_SET_CLEAR3, \
+  true, true, /* auto-config reconfig, calibration */ \
+  false, false, false, false /* auto-config skip charge time, OOR, ARF, ACF interrupts */ \
+}
+
+
+class mpr121Reader;
+class mpr121Recorder;
+class mpr121PowerManager;
+class mpr121IrqDispatcher;
+class mpr121BusBudget;
+class mpr121ResetMonitor;
+
+
 /**
  * Main mpr121 class.
  * Use one instance per MPR121.
  */
+#if MPR121_CONFIG_PROFILES
 class mpr121 {
-private:
+#else
+class mpr121 : public mpr121Config {
+#endif
+  friend class mpr121Reader;
+  friend class mpr121Recorder;
+  friend class mpr121PowerManager;
+  friend class mpr121IrqDispatcher;
+  friend class mpr121ResetMonitor;
+
+protected:
   byte i2cAddr; ///< I2C address from constructor
   TwoWire* i2cWire; ///< TwoWire* from constructor
+  #if MPR121_FEATURE_TRANSPORT
+    mpr121Transport* transport; ///< Transport from setTransport (used instead of i2cWire if set)
+  #endif
+  #if MPR121_FEATURE_BUDGET
+    mpr121BusBudget* budget; ///< Budget from setBusBudget (null if traffic isn't budgeted)
+  #endif
+
+  #if MPR121_CONFIG_PROFILES
+    const mpr121Config* config; ///< Profile from setConfig/setConfig_P (null to use defaults)
+    bool configInProgmem; ///< Whether config points to PROGMEM
+  #endif
 
-  static byte i2cReadBuf[MPR121_I2C_BUFLEN]; ///< Intermediate buffer for raw I2C reads
+  #if MPR121_READER_THREAD
+    static thread_local byte i2cReadBuf[MPR121_I2C_BUFLEN]; ///< Intermediate buffer for raw I2C reads (one per thread so reader threads on different buses don't clash)
+  #else
+    static byte i2cReadBuf[MPR121_I2C_BUFLEN]; ///< Intermediate buffer for raw I2C reads
+  #endif
   
   #if MPR121_SAVE_MEMORY
-    static short electrodeDataBuf[13]; ///< Return buffer for analog electrode data
-    static byte electrodeBaselineBuf[13]; ///< Return buffer for electrode baselines
-    static byte electrodeCDCBuf[13]; ///< Return buffer for electrode CDC
-    static mpr121FilterCDT electrodeCDTBuf[13]; ///< Return buffer for electrode CDT
+    #if MPR121_FEATURE_ANALOG
+      static short electrodeDataBuf[13]; ///< Return buffer for analog electrode data
+      static byte electrodeBaselineBuf[13]; ///< Return buffer for electrode baselines
+      static short electrodeDeltaBuf[13]; ///< Return buffer for electrode deltas
+    #endif
+    #if MPR121_FEATURE_CHARGE
+      static byte electrodeCDCBuf[13]; ///< Return buffer for electrode CDC
+      static mpr121FilterCDT electrodeCDTBuf[13]; ///< Return buffer for electrode CDT
+    #endif
     #if !MPR121_USE_BITFIELDS
       bool electrodeTouchBuf[13]; ///< Return buffer for digital electrode data
       static bool electrodeOORBuf[15]; ///< Return buffer for out-of-range flags
     #endif
   #else // MPR121_SAVE_MEMORY
-    short electrodeDataBuf[13]; ///< Return buffer for analog electrode data
-    byte electrodeBaselineBuf[13]; ///< Return buffer for electrode baselines
-    byte electrodeCDCBuf[13]; ///< Return buffer for electrode CDC
-    mpr121FilterCDT electrodeCDTBuf[13]; ///< Return buffer for electrode CDT
+    #if MPR121_FEATURE_ANALOG
+      short electrodeDataBuf[13]; ///< Return buffer for analog electrode data
+      byte electrodeBaselineBuf[13]; ///< Return buffer for electrode baselines
+      short electrodeDeltaBuf[13]; ///< Return buffer for electrode deltas
+    #endif
+    #if MPR121_FEATURE_CHARGE
+      byte electrodeCDCBuf[13]; ///< Return buffer for electrode CDC
+      mpr121FilterCDT electrodeCDTBuf[13]; ///< Return buffer for electrode CDT
+    #endif
     #if !MPR121_USE_BITFIELDS
       bool electrodeTouchBuf[13]; ///< Return buffer for digital electrode data
       bool electrodeOORBuf[15]; ///< Return buffer for out-of-range flags
@@ -120,6 +479,22 @@ private:
     short electrodeTouchCache; ///< Cache for digital single electrode reads
   #endif
   unsigned long electrodeTouchCacheMicros; ///< Last update time for electrodeTouchCache (or electrodeTouchBuf if no bitfields)
+
+  #if MPR121_FEATURE_ANALOG
+    unsigned long samplePeriodMicros; ///< Chip sample period (ESI), set by setFilterConfig
+    unsigned long lastSampleMicros; ///< Host time of the last tracked sample
+    unsigned long sampleIndex; ///< Estimated chip sample index of the last frame
+    unsigned long duplicateSamples; ///< Number of frames that read an already-seen sample
+    unsigned long droppedSamples; ///< Number of samples missed between frames
+    unsigned short lastFrameChecksum; ///< Checksum of the last frame's registers, to detect new samples
+    bool sampleTracking; ///< Whether the sample tracking fields have been set since start()
+
+    /**
+     * Updates sample tracking from a raw frame read at microsNow.
+     * Returns the estimated chip sample index.
+     */
+    unsigned long trackSample(const byte* rawdata, unsigned long microsNow);
+  #endif
   
   
   /**
@@ -127,6 +502,18 @@ private:
    */
   void writeRegister(mpr121Register addr, byte value);
 
+  /**
+   * Writes values to consecutive MPR121 registers in one transaction.
+   * Max count is equal to the MPR121_I2C_BUFLEN define minus one (for the address byte).
+   */
+  void writeRegister(mpr121Register addr, const byte* values, byte count);
+
+  /**
+   * Writes values to consecutive MPR121 registers.
+   * Unlike writeRegister, count isn't limited (writes are split into MPR121_I2C_BUFLEN - 1 chunks as necessary).
+   */
+  void writeRegisters(mpr121Register addr, const byte* values, byte count);
+
   /**
    * Reads bytes from consecutive MPR121 registers.
    * Max count is equal to the MPR121_I2C_BUFLEN define.
@@ -140,6 +527,139 @@ private:
     return readRegister(addr, 1)[0];
   }
 
+  /**
+   * Reads bytes from consecutive MPR121 registers into dest.
+   * Unlike readRegister, count isn't limited (reads are split into MPR121_I2C_BUFLEN chunks as necessary).
+   */
+  void readRegisters(mpr121Register addr, byte count, byte* dest);
+
+  /**
+   * Sends a write, budgeted if a bus budget is set (no capturing or batching).
+   */
+  void sendWrite(mpr121Register addr, const byte* values, byte count);
+
+  /**
+   * Sends a write to the transport or TwoWire instance (no capturing or budgeting).
+   */
+  void busWrite(mpr121Register addr, const byte* values, byte count);
+
+  /**
+   * Sends a read to the transport or TwoWire instance (no capturing or budgeting).
+   * Returns the number of bytes actually read.
+   */
+  byte busRead(mpr121Register addr, byte* dest, byte count);
+
+  #if MPR121_FEATURE_BUDGET
+    /**
+     * Gets the budget priority class of a transaction.
+     */
+    static mpr121BusPriority getBusPriority(mpr121Register addr, byte count, bool read);
+
+    /**
+     * Waits for (or takes) budget for a write, and handles deferred LED writes.
+     * Returns true if the write was deferred and shouldn't be sent yet.
+     */
+    bool budgetWrite(mpr121Register addr, const byte* values, byte count);
+
+    /**
+     * Waits for budget for a read, and handles deferred LED writes.
+     * Returns true if the read was already done (or answered from known PWM values) into dest.
+     */
+    bool budgetRead(mpr121Register addr, byte* dest, byte count);
+
+    #if MPR121_FEATURE_GPIO
+      byte ledPWM[4]; ///< PWM register values as they will be once deferred writes are sent
+      byte ledPWMKnown; ///< Which ledPWM values are known (bit 0 is PWM_DUTY_0)
+      byte ledPWMDeferred; ///< Which ledPWM values haven't been sent yet
+      byte ledGPIOForce; ///< GPIO data bits set or cleared by deferred writes
+      byte ledGPIOValue; ///< Values of the ledGPIOForce bits
+      byte ledGPIOToggle; ///< GPIO data bits toggled by deferred writes (never overlaps ledGPIOForce)
+
+      /**
+       * Checks if there are deferred LED writes.
+       */
+      bool hasDeferredLEDWrites() {
+        return ledPWMDeferred || ledGPIOForce || ledGPIOToggle;
+      }
+
+      /**
+       * Merges a GPIO data or PWM write into the deferred LED writes.
+       */
+      void deferLEDWrite(mpr121Register addr, byte value);
+
+      /**
+       * Sends deferred LED writes (PWM first, then GPIO data, the same order the GPIO functions use).
+       * If wait is false, gives up (returning false) when the budget can't pay for them yet.
+       */
+      bool flushLEDWrites(bool wait);
+    #endif
+  #endif
+
+  #if MPR121_FEATURE_BATCH
+    byte batchDepth; ///< Number of beginBatch() calls without a matching commit()
+    byte batchCount; ///< Number of queued writes
+    byte batchRegs[MPR121_BATCH_LEN]; ///< Registers of queued writes
+    byte batchValues[MPR121_BATCH_LEN]; ///< Values of queued writes
+
+    /**
+     * Queues a write while batching (replacing any queued write to the same register).
+     * Returns false if it has to be sent now instead (anything already queued is sent first).
+     */
+    bool queueWrite(mpr121Register addr, const byte* values, byte count);
+
+    /**
+     * Sends queued writes, sorted by register and merged into bursts.
+     */
+    void flushBatch();
+
+    /**
+     * Checks if writes to a register can't be queued (because they must stay in order with other writes, or aren't last-write-wins).
+     */
+    static bool isBatchBarrier(byte reg);
+  #endif
+
+  #if MPR121_FEATURE_APPLY
+    byte configImage[MPR121_RAW_CONFIG_LEN]; ///< Config registers (0x2B-0x7F) as last written (power-on values if never written, GPIO data includes set/clear/toggle writes)
+    bool configImageValid; ///< Whether configImage has all settings (set once start() has written them)
+    byte* configCapture; ///< If set, config register writes are stored here instead of being sent (used by apply())
+
+    /**
+     * Records writes to config registers in configImage, or configCapture if set.
+     * Returns true if the write was captured and shouldn't be sent.
+     */
+    bool trackConfigWrite(mpr121Register addr, const byte* values, byte count);
+
+    /**
+     * Sets configImage to power-on register values and marks it invalid (until start() writes all settings).
+     */
+    void resetConfigImage();
+
+    /**
+     * Checks if a config register can only be written in stop mode.
+     */
+    static bool requiresStop(byte reg);
+  #endif
+
+  /**
+   * Gets an electrode configuration value that restarts with the same electrodes without reloading baselines
+   * (calibration lock modes that load baselines are changed to plain tracking, which behaves the same once running).
+   */
+  static byte getRestartECR(byte ecr) {
+    return (ecr & 0b10000000) ? ecr & 0b00111111 : ecr;
+  }
+
+  /**
+   * Clears auto-configuration enable (ACE) in stop mode, so the next restart keeps baselines and charge settings.
+   * This is sent directly, so the config image keeps the configured value (start() sets it again).
+   */
+  void skipAutoConfig();
+
+  /**
+   * Writes all settings (except electrode configuration) from cfg.
+   * Values with less than 8 bits are masked in cfg, and autoconfig limits are calculated if not set.
+   */
+  void writeConfig(mpr121Config &cfg);
+
 
   /**
    * Checks if an electrode number and count are valid and suitable for use.
@@ -184,6 +704,12 @@ private:
     setElectrodeThresholds(electrode, 1, touchThreshold, releaseThreshold);
   }
 
+  /**
+   * Sets the touch and release thresholds for all electrodes from arrays of 13 values.
+   * Uses bursts over the interleaved threshold registers (0x41-0x5A).
+   */
+  void setElectrodeThresholds(const byte* touchThresholds, const byte* releaseThresholds);
+
 
   /**
    * Sets the "Max Half Delta" baseline filter values.
@@ -291,15 +817,17 @@ private:
   void setAutoConfig(byte USL, byte LSL, byte TL, mpr121AutoConfigRetry RETRY, mpr121AutoConfigBVA BVA, bool ARE, bool ACE, bool SCTS, bool OORIE, bool ARFIE, bool ACFIE);
 
 
-  /**
-   * Sets the GPIO PWM value for consecutive pins.
-   * (AN3894)
-   * 
-   * Max value is 15
-   * Pin 9 apparently has a logic bug and pin 10 must also have its data set high for it to work.
-   *   (https://community.nxp.com/thread/305474)
-   */
-  void setPWM(byte pin, byte count, byte value);
+  #if MPR121_FEATURE_GPIO
+    /**
+     * Sets the GPIO PWM value for consecutive pins.
+     * (AN3894)
+     * 
+     * Max value is 15
+     * Pin 9 apparently has a logic bug and pin 10 must also have its data set high for it to work.
+     *   (https://community.nxp.com/thread/305474)
+     */
+    void setPWM(byte pin, byte count, byte value);
+  #endif
   
 public:
   /**
@@ -310,69 +838,84 @@ public:
    */
   mpr121(byte addr = 0, TwoWire *wire = &Wire);
 
-  byte touchThresholds[13]; ///< Touch detection thresholds for ELE0-ELE11 and ELEPROX
-  byte releaseThresholds[13]; ///< Release detection thresholds for ELE0-ELE11 and ELEPROX
-
-  byte MHDrising; ///< "Max Half Delta" rising baseline adjustment value (AN3891) -- max: 63
-  byte MHDfalling; ///< "Max Half Delta" falling baseline adjustment value (AN3891) -- max: 63
-  
-  byte NHDrising; ///< "Noise Half Delta" rising baseline adjustment value (AN3891) -- max: 63
-  byte NHDfalling; ///< "Noise Half Delta" falling baseline adjustment value (AN3891) -- max: 63
-  byte NHDtouched; ///< "Noise Half Delta" touched baseline adjustment value (AN3891) -- max: 63
-  
-  byte NCLrising; ///< "Noise Count Limit" rising baseline adjustment value (AN3891)
-  byte NCLfalling; ///< "Noise Count Limit" falling baseline adjustment value (AN3891)
-  byte NCLtouched; ///< "Noise Count Limit" touched baseline adjustment value (AN3891)
-  
-  byte FDLrising; ///< "Filter Delay Limit" rising baseline adjustment value (AN3891)
-  byte FDLfalling; ///< "Filter Delay Limit" falling baseline adjustment value (AN3891)
-  byte FDLtouched; ///< "Filter Delay Limit" touched baseline adjustment value (AN3891)
-
-  
-  byte MHDrisingProx; ///< "Max Half Delta" rising value for proximity detection (AN3891/AN3893) -- max: 63
-  byte MHDfallingProx; ///< "Max Half Delta" falling value for proximity detection (AN3891/AN3893) -- max: 63
-  
-  byte NHDrisingProx; ///< "Noise Half Delta" rising value for proximity detection (AN3891/AN3893) -- max: 63
-  byte NHDfallingProx; ///< "Noise Half Delta" falling value for proximity detection (AN3891/AN3893) -- max: 63
-  byte NHDtouchedProx; ///< "Noise Half Delta" touched value for proximity detection (AN3891/AN3893) -- max: 63
-  
-  byte NCLrisingProx; ///< "Noise Count Limit" rising value for proximity detection (AN3891/AN3893)
-  byte NCLfallingProx; ///< "Noise Count Limit" falling value for proximity detection (AN3891/AN3893)
-  byte NCLtouchedProx; ///< "Noise Count Limit" touched value for proximity detection (AN3891/AN3893)
-  
-  byte FDLrisingProx; ///< "Filter Delay Limit" rising value for proximity detection (AN3891/AN3893)
-  byte FDLfallingProx; ///< "Filter Delay Limit" falling value for proximity detection (AN3891/AN3893)
-  byte FDLtouchedProx; ///< "Filter Delay Limit" touched value for proximity detection (AN3891/AN3893)
+  #if MPR121_FEATURE_TRANSPORT
+    /**
+     * Routes register access through an alternative transport instead of the TwoWire instance.
+     * Pass nullptr to go back to using TwoWire.
+     */
+    void setTransport(mpr121Transport* transport) {
+      this->transport = transport;
+    }
+  #endif
 
+  #if MPR121_FEATURE_BUDGET
+    /**
+     * Limits this device's bus traffic with a budget (see mpr121BusBudget, QuickMpr121Budget.h).
+     * Share one budget between all devices on a bus. Pass nullptr to stop budgeting.
+     * 
+     * Touch status reads are never delayed. Other reads and writes wait until the budget allows them (up to its maxWaitMicros),
+     * except GPIO data and PWM writes, which are coalesced while the budget is tight and sent once it recovers.
+     * Configuration writes (including start()) are lowest priority, so set the budget after starting if the bus is busy.
+     */
+    void setBusBudget(mpr121BusBudget* budget);
+
+    #if MPR121_FEATURE_GPIO
+      /**
+       * Sends any GPIO data and PWM writes that have been coalesced while the bus budget was tight, waiting for the budget if necessary.
+       * Deferred writes are also sent automatically by later register access once the budget allows.
+       */
+      void flushDeferredWrites() {
+        flushLEDWrites(true);
+      }
+    #endif
+  #endif
 
-  byte debounceTouch; ///< Set "Debounce" count for touches (times a detection must be sampled) -- max: 7
-  byte debounceRelease; ///< Set "Debounce" count for releases (times a detection must be sampled) -- max: 7
+  /**
+   * Gets the I2C address of this MPR121.
+   */
+  byte getAddress() {
+    return i2cAddr;
+  }
 
+  #if MPR121_CONFIG_PROFILES
+    /**
+     * Sets the profile to use when starting (must stay valid while the mpr121 is used).
+     * Many devices can share one profile. Pass nullptr to use default settings.
+     */
+    void setConfig(const mpr121Config* profile) {
+      config = profile;
+      configInProgmem = false;
+    }
 
-  mpr121FilterFFI FFI; ///< "First Filter Iterations" (number of samples taken for the first level of filtering)
-  byte globalCDC; ///< Global "Charge Discharge Current" (μA), not used if autoconfig is enabled -- max 63
-  mpr121FilterCDT globalCDT; ///< Global "Charge Discharge Time" (μs), not used if autoconfig is enabled
-  mpr121FilterSFI SFI; ///< "Second Filter Iterations" (number of samples taken for the second level of filtering)
-  mpr121FilterESI ESI; ///< "Electrode Sample Interval" (ms)
+    /**
+     * Sets a PROGMEM profile to use when starting (see setConfig).
+     */
+    void setConfig_P(const mpr121Config* profile) {
+      config = profile;
+      configInProgmem = true;
+    }
+  #endif
 
+  /**
+   * Copies the settings that will be used by start().
+   */
+  void getConfig(mpr121Config &out);
 
-  mpr121ElectrodeConfigCL calLock; ///< "Calibration Lock" (baseline tracking and initial value settings)
-  mpr121ElectrodeConfigProx proxEnable; ///< ELEPROX_EN: sets what electrodes will be used for proximity detection
+  /**
+   * Writes touchThresholds and releaseThresholds for all electrodes.
+   * The 26 interleaved registers (0x41-0x5A) are sent in one or two bursts, depending on MPR121_I2C_BUFLEN.
+   * 
+   * The MPR121 ignores threshold writes while running, so if it's running it's stopped just for the writes
+   * and restarted with the same electrodes. Auto-configuration is skipped for the restart and calLock modes that load baselines are
+   * treated as plain tracking, so baselines and charge settings are kept (start() re-enables auto-configuration if it's configured).
+   */
+  void writeThresholds();
 
-  byte autoConfigUSL; ///< "Up-Side Limit" for auto calibration -- if not set when starting, this will be automatically set to the ideal value for 1.8V supply
-  byte autoConfigLSL; ///< "Low-Side Limit" for auto calibration -- if not set when starting, this will be automatically set based on USL
-  byte autoConfigTL; ///< "Target Level" for auto calibration -- if not set when starting, this will be automatically set based on USL
-  mpr121AutoConfigRetry autoConfigRetry; ///< Number of retries for failed auto-config before out of range will be set
-  mpr121AutoConfigBVA autoConfigBaselineAdjust; ///< "Baseline Value Adjust" changes how the baseline registers will be set after auto-configuration completes
-  bool autoConfigEnableReconfig; ///< "Automatic Reconfiguration Enable" will try to reconfigure out of range (failed) channels every sampling interval
-  bool autoConfigEnableCalibration; ///< "Automatic Configuration Enable" will enable/disable auto-configuration when entering run mode
-  
-  bool autoConfigSkipChargeTime; ///< "Skip Charge Time Search" will skip searching for charge time and use the already-set per-electrode or global value
-                                 ///< 
-                                 ///< This results in a shorter time to configure, but the designer must supply appropriate values.
-  bool autoConfigInterruptOOR; ///< "Out-of-range interrupt enable" will trigger an interrupt when a channel is determined to be out of range
-  bool autoConfigInterruptARF; ///< "Auto-reconfiguration fail interrupt enable" will trigger an interrupt when auto-reconfiguration fails
-  bool autoConfigInterruptACF; ///< "Auto-configuration fail interrupt enable" will trigger an interrupt when auto-configuration fails
+  /**
+   * Reads touch and release thresholds for all electrodes in one burst, into arrays of 13 values.
+   * (for example, `mpr.readThresholds(touch, release)` to check writeThresholds() worked)
+   */
+  void readThresholds(byte* touchThresholds, byte* releaseThresholds);
 
 
   /** 
@@ -422,150 +965,245 @@ public:
    */
   void clearOverCurrent();
 
-  /**
-   * Reads filtered analog data for consecutive electrodes.
-   */
-  short* readElectrodeData(byte electrode, byte count);
+  #if MPR121_FEATURE_ANALOG
+    /**
+     * Reads status, filtered analog data, and baselines for all electrodes into a caller-owned frame.
+     * This uses burst reads over the whole 0x00-0x2A register range.
+     * 
+     * frame.sample is estimated from the time since the last new data and the sample interval (ESI).
+     * If the registers haven't changed and less than one sample interval has passed, the frame is counted as a duplicate.
+     * If more than one sample interval has passed before new data, the skipped samples are counted as dropped.
+     */
+    void readFrame(mpr121Frame &frame);
+
+    /**
+     * Gets the number of frames read by readFrame() that didn't have a new sample (polling faster than ESI).
+     */
+    unsigned long getDuplicateSamples() {
+      return duplicateSamples;
+    }
+
+    /**
+     * Gets the estimated number of samples that were never read by readFrame() (polling slower than ESI).
+     */
+    unsigned long getDroppedSamples() {
+      return droppedSamples;
+    }
+
+    /**
+     * Resets the duplicate and dropped sample counters.
+     */
+    void resetSampleCounters() {
+      duplicateSamples = 0;
+      droppedSamples = 0;
+    }
+
+    /**
+     * Reads the raw status, filtered analog data, and baseline registers (0x00-0x2A) into rawdata.
+     * rawdata must have space for MPR121_RAW_FRAME_LEN bytes.
+     * Returns a view over rawdata.
+     */
+    mpr121RawFrame readRawFrame(byte* rawdata);
+
+    /**
+     * Decodes raw registers from readRawFrame into a frame.
+     * (frame.micros and frame.sample aren't changed)
+     */
+    static void decodeFrame(const byte* rawdata, mpr121Frame &frame);
+
+    /**
+     * Reads filtered analog data for consecutive electrodes.
+     */
+    short* readElectrodeData(byte electrode, byte count);
   
-  /**
-   * Reads filtered analog data for a single electrode.
-   */
-  short readElectrodeData(byte electrode) {
-    return readElectrodeData(electrode, 1)[0];
-  }
+    /**
+     * Reads filtered analog data for a single electrode.
+     */
+    short readElectrodeData(byte electrode) {
+      return readElectrodeData(electrode, 1)[0];
+    }
   
-  /**
-   * Reads baseline values for consecutive electrodes.
-   */
-  byte* readElectrodeBaseline(byte electrode, byte count);
+    /**
+     * Reads baseline values for consecutive electrodes.
+     */
+    byte* readElectrodeBaseline(byte electrode, byte count);
   
-  /**
-   * Reads the baseline value for a single electrode.
-   */
-  byte readElectrodeBaseline(byte electrode) {
-    return readElectrodeBaseline(electrode, 1)[0];
-  }
+    /**
+     * Reads the baseline value for a single electrode.
+     */
+    byte readElectrodeBaseline(byte electrode) {
+      return readElectrodeBaseline(electrode, 1)[0];
+    }
 
-  /**
-   * Writes a baseline value to consecutive electrodes.
-   */
-  void writeElectrodeBaseline(byte electrode, byte count, byte value);
+    /**
+     * Reads the difference between filtered analog data and baselines (`filtered - (baseline << 2)`) for consecutive electrodes.
+     * 
+     * If `26 - electrode + count <= MPR121_I2C_BUFLEN` (everything from the first electrode's data to the last electrode's baseline fits in one read),
+     * data and baselines are read in one burst, so they're from the same sample.
+     * Otherwise, data and baselines are read separately and may be from different samples.
+     * Positive values mean capacitance is lower than the baseline (usually not touched), negative values mean it's higher (usually touched).
+     */
+    short* readElectrodeDelta(byte electrode, byte count);
   
-  /**
-   * Writes the baseline value for a single electrode.
-   */
-  void writeElectrodeBaseline(byte electrode, byte value) {
-    writeElectrodeBaseline(electrode, 1, value);
-  }
+    /**
+     * Reads the difference between filtered analog data and the baseline (`filtered - (baseline << 2)`) for a single electrode.
+     */
+    short readElectrodeDelta(byte electrode) {
+      return readElectrodeDelta(electrode, 1)[0];
+    }
 
-  /**
-   * A quick way to set all ::touchThresholds and ::releaseThresholds.
-   * 
-   * \param prox  Whether to set proximity detection thresholds too.
-   */
-  void setAllThresholds(byte touched, byte released, bool prox);
+    /**
+     * Writes a baseline value to consecutive electrodes.
+     */
+    void writeElectrodeBaseline(byte electrode, byte count, byte value);
   
+    /**
+     * Writes the baseline value for a single electrode.
+     */
+    void writeElectrodeBaseline(byte electrode, byte value) {
+      writeElectrodeBaseline(electrode, 1, value);
+    }
+
+    /**
+     * Saves filtered analog data and baselines for all electrodes.
+     * Filtered data and baselines (0x1E-0x2A) are read in separate bursts, so they may be from different samples.
+     */
+    void snapshotBaselines(mpr121BaselineSnapshot &snapshot);
+
+    /**
+     * Writes baselines from a snapshot back to the electrodes in mask (bit 0 is ELE0, bit 12 is ELEPROX) in one burst.
+     * If mask has gaps, current baselines for the gaps are read first (also in one burst) so they can be written back unchanged.
+     * 
+     * Baselines can only be written in stop mode, so if the MPR121 is running, it's stopped briefly and restarted with the same electrodes
+     * (this also stops tracking from changing the gaps between the read and the write).
+     * Auto-configuration is skipped for the restart and calibration lock modes that load baselines on start are treated as plain tracking,
+     * so the restored values are kept.
+     * With calLock set to MPR_CL_TRACKING_DISABLED, restored baselines are kept as-is. Otherwise, tracking continues from them.
+     * 
+     * If restoring while stopped, start() runs with the configured settings, so use MPR_CL_TRACKING_ENABLED (so baselines aren't reloaded from the first sample)
+     * and disable auto-configuration (autoConfigEnableCalibration) or use MPR_AUTOCONFIG_BVA_DISABLED.
+     */
+    void restoreBaselines(const mpr121BaselineSnapshot &snapshot, short mask = 0x1fff);
+  #endif
+
   
-  /**
-   * Reads per-electrode "Charge Discharge Current" (μA) for consecutive electrodes.
-   */
-  byte* readElectrodeCDC(byte electrode, byte count);
+  #if MPR121_FEATURE_CHARGE
+    /**
+     * Reads per-electrode "Charge Discharge Current" (μA) for consecutive electrodes.
+     */
+    byte* readElectrodeCDC(byte electrode, byte count);
   
-  /**
-   * Reads per-electrode "Charge Discharge Current" (μA) for a single electrode.
-   */
-  byte readElectrodeCDC(byte electrode) {
-    return readElectrodeCDC(electrode, 1)[0];
-  }
+    /**
+     * Reads per-electrode "Charge Discharge Current" (μA) for a single electrode.
+     */
+    byte readElectrodeCDC(byte electrode) {
+      return readElectrodeCDC(electrode, 1)[0];
+    }
   
-  /**
-   * Writes per-electrode "Charge Discharge Current" (μA) for consecutive electrodes.
-   * Max: 63
-   */
-  void writeElectrodeCDC(byte electrode, byte count, byte value);
+    /**
+     * Writes per-electrode "Charge Discharge Current" (μA) for consecutive electrodes.
+     * Max: 63
+     */
+    void writeElectrodeCDC(byte electrode, byte count, byte value);
   
-  /**
-   * Writes per-electrode "Charge Discharge Current" (μA) for a single electrode.
-   * Max: 63
-   */
-  void writeElectrodeCDC(byte electrode, byte value) {
-    writeElectrodeCDC(electrode, 1, value);
-  }
+    /**
+     * Writes per-electrode "Charge Discharge Current" (μA) for a single electrode.
+     * Max: 63
+     */
+    void writeElectrodeCDC(byte electrode, byte value) {
+      writeElectrodeCDC(electrode, 1, value);
+    }
   
-  /**
-   * Reads per-electrode "Charge Discharge Time" (μs) for consecutive electrodes.
-   */
-  mpr121FilterCDT* readElectrodeCDT(byte electrode, byte count);
+    /**
+     * Reads per-electrode "Charge Discharge Time" (μs) for consecutive electrodes.
+     */
+    mpr121FilterCDT* readElectrodeCDT(byte electrode, byte count);
   
-  /**
-   * Reads per-electrode "Charge Discharge Time" (μs) for a single electrode.
-   */
-  mpr121FilterCDT readElectrodeCDT(byte electrode) {
-    return readElectrodeCDT(electrode, 1)[0];
-  }
+    /**
+     * Reads per-electrode "Charge Discharge Time" (μs) for a single electrode.
+     */
+    mpr121FilterCDT readElectrodeCDT(byte electrode) {
+      return readElectrodeCDT(electrode, 1)[0];
+    }
   
-  /**
-   * Writes per-electrode "Charge Discharge Time" (μs) for consecutive electrodes.
-   */
-  void writeElectrodeCDT(byte electrode, byte count, mpr121FilterCDT value);
+    /**
+     * Writes per-electrode "Charge Discharge Time" (μs) for consecutive electrodes.
+     */
+    void writeElectrodeCDT(byte electrode, byte count, mpr121FilterCDT value);
   
-  /**
-   * Writes per-electrode "Charge Discharge Time" (μs) for a single electrode.
-   */
-  void writeElectrodeCDT(byte electrode, mpr121FilterCDT value) {
-    writeElectrodeCDT(electrode, 1, value);
-  }
+    /**
+     * Writes per-electrode "Charge Discharge Time" (μs) for a single electrode.
+     */
+    void writeElectrodeCDT(byte electrode, mpr121FilterCDT value) {
+      writeElectrodeCDT(electrode, 1, value);
+    }
 
+    /**
+     * Reads CDC and CDT for all electrodes in one burst.
+     * Useful for saving auto-configuration results.
+     */
+    void readChargeConfig(mpr121ChargeConfig &config);
 
-  /**
-   * Sets pin mode for consecutive GPIO pins.
-   * 
-   * GPIO can be used on pins 4-11 when they aren't used for sensing.
-   * Use mode MPR_GPIO_MODE_OUTPUT_OPENDRAIN_HIGH for direct LED driving -- it can source up to 12mA.
-   */
-  void setGPIOMode(byte pin, byte count, mpr121GPIOMode mode);
+    /**
+     * Writes CDC and CDT for all electrodes in one burst (CDT values are packed locally, so nothing needs to be read first).
+     * 
+     * The MPR121 ignores this while running, so call stop() first (or use it before start() with auto-configuration disabled or SCTS set).
+     */
+    void writeChargeConfig(const mpr121ChargeConfig &config);
+  #endif
 
-  /**
-   * Sets pin mode for a single GPIO pin.
-   * 
-   * GPIO can be used on pins 4-11 when they aren't used for sensing.
-   * Use mode MPR_GPIO_MODE_OUTPUT_OPENDRAIN_HIGH for direct LED driving -- it can source up to 12mA.
-   */
-  void setGPIOMode(byte pin, mpr121GPIOMode mode) {
-    setGPIOMode(pin, 1, mode);
-  }
 
-  /**
-   * Writes a digital value to consecutive GPIO pins.
-   */
-  void writeGPIODigital(byte pin, byte count, bool value);
+  #if MPR121_FEATURE_GPIO
+    /**
+     * Sets pin mode for consecutive GPIO pins.
+     * 
+     * GPIO can be used on pins 4-11 when they aren't used for sensing.
+     * Use mode MPR_GPIO_MODE_OUTPUT_OPENDRAIN_HIGH for direct LED driving -- it can source up to 12mA.
+     */
+    void setGPIOMode(byte pin, byte count, mpr121GPIOMode mode);
 
-  /**
-   * Writes a digital value to a single GPIO pin.
-   */
-  void writeGPIODigital(byte pin, bool value) {
-    writeGPIODigital(pin, 1, value);
-  }
+    /**
+     * Sets pin mode for a single GPIO pin.
+     * 
+     * GPIO can be used on pins 4-11 when they aren't used for sensing.
+     * Use mode MPR_GPIO_MODE_OUTPUT_OPENDRAIN_HIGH for direct LED driving -- it can source up to 12mA.
+     */
+    void setGPIOMode(byte pin, mpr121GPIOMode mode) {
+      setGPIOMode(pin, 1, mode);
+    }
 
-  /**
-   * Writes an "analog" (PWM) value to consecutive GPIO pins.
-   * Max value is 15
-   * 
-   * Pin 9 apparently has a logic bug and pin 10 must also have its data set high for it to work.
-   *   (see https://community.nxp.com/thread/305474)
-   */
-  void writeGPIOAnalog(byte pin, byte count, byte value);
+    /**
+     * Writes a digital value to consecutive GPIO pins.
+     */
+    void writeGPIODigital(byte pin, byte count, bool value);
 
-  /**
-   * Writes an "analog" (PWM) value to a single GPIO pin.
-   * Max value is 15
-   * 
-   * Pin 9 apparently has a logic bug and pin 10 must also have its data set high for it to work.
-   *   (see https://community.nxp.com/thread/305474)
-   */
-  void writeGPIOAnalog(byte pin, byte value) {
-    writeGPIOAnalog(pin, 1, value);
-  }
+    /**
+     * Writes a digital value to a single GPIO pin.
+     */
+    void writeGPIODigital(byte pin, bool value) {
+      writeGPIODigital(pin, 1, value);
+    }
+
+    /**
+     * Writes an "analog" (PWM) value to consecutive GPIO pins.
+     * Max value is 15
+     * 
+     * Pin 9 apparently has a logic bug and pin 10 must also have its data set high for it to work.
+     *   (see https://community.nxp.com/thread/305474)
+     */
+    void writeGPIOAnalog(byte pin, byte count, byte value);
+
+    /**
+     * Writes an "analog" (PWM) value to a single GPIO pin.
+     * Max value is 15
+     * 
+     * Pin 9 apparently has a logic bug and pin 10 must also have its data set high for it to work.
+     *   (see https://community.nxp.com/thread/305474)
+     */
+    void writeGPIOAnalog(byte pin, byte value) {
+      writeGPIOAnalog(pin, 1, value);
+    }
+  #endif
 
 
   /**
@@ -580,6 +1218,21 @@ public:
    * Very much based on the quick start guide (AN3944).
    */
   void start(byte electrodes);
+
+  #if MPR121_FEATURE_APPLY
+    /**
+     * Applies changed settings without restarting.
+     * 
+     * Settings are compared against what was last written, and only changed registers are written (consecutive registers are combined into bursts).
+     * Run mode is only left if a changed register can't be written while running (everything except electrode configuration and GPIO registers, so thresholds too).
+     * In that case, the MPR121 is stopped briefly and restarted with the same electrodes. Baselines and charge settings are kept
+     * (auto-configuration is skipped for the restart, and calLock modes that load baselines are treated as plain tracking).
+     * Call start() instead to re-run auto-configuration.
+     * 
+     * If start() hasn't been called yet (or after softReset()), there's nothing to compare against, so all settings are written.
+     */
+    void apply();
+  #endif
   
   #ifndef NO_DOXYGEN
     // (deprecated) alias for start
@@ -611,5 +1264,28 @@ public:
    * Resets the MPR121.
    */
   void softReset();
+
+  #if MPR121_FEATURE_BATCH
+    /**
+     * Starts queueing register writes instead of sending them immediately, until commit().
+     * 
+     * Queued writes are last-write-wins per register, and are sent sorted by register with consecutive registers merged into bursts.
+     * All setters and GPIO functions batch this way without changes, and reads inside a batch see queued values.
+     * Writes that must stay in order (electrode configuration, status, GPIO enable, GPIO set/clear/toggle, and soft reset) send the queue first and aren't queued themselves.
+     * If more than MPR121_BATCH_LEN registers are queued, the queue is sent early.
+     * 
+     * Batches can be nested -- writes are sent by the outermost commit().
+     * start() and the GPIO functions already batch internally.
+     */
+    void beginBatch() {
+      if (batchDepth < 255)
+        batchDepth++;
+    }
+
+    /**
+     * Ends a batch started by beginBatch(), sending queued writes in as few transactions as possible.
+     */
+    void commit();
+  #endif
 };
 
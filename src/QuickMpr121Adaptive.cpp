@@ -0,0 +1,138 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Adaptive analog data reads.
+ * More info in QuickMpr121Adaptive.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Adaptive.h"
+
+#if MPR121_FEATURE_ANALOG
+
+// Creates an adaptive reader for an mpr121.
+// electrodes: Number of electrodes in use (the same as passed to mpr121::start(), or 13 to include ELEPROX).
+mpr121AdaptiveReader::mpr121AdaptiveReader(mpr121 &mpr, byte electrodes)
+{
+  if (electrodes > 13)
+    electrodes = 13;
+
+  this->mpr = &mpr;
+  this->electrodes = electrodes;
+  electrodeMask = (1 << electrodes) - 1;
+
+  lastTouch = 0;
+  freshMask = 0;
+  readsSinceRefresh = 0xff; // read everything on the first read
+
+  for (byte i = 0; i < 13; i++) {
+    changeHold[i] = 0;
+    electrodeData[i] = 0;
+  }
+
+  neighbours = 1;
+  changeHoldReads = 4;
+  fullRefreshInterval = 50;
+  transactionOverhead = 4;
+}
+
+
+// Reads touch state, then analog data for the electrodes that need it.
+// Returns the 13 touch state bits (same as mpr121::readTouchState()).
+short mpr121AdaptiveReader::read() {
+  #if MPR121_USE_BITFIELDS
+    short touch = mpr->readTouchState();
+  #else
+    bool* touchBools = mpr->readTouchState();
+    short touch = 0;
+    for (byte i = 0; i < 13; i++) {
+      bitWrite(touch, i, touchBools[i]);
+    }
+  #endif
+
+  // find electrodes that are touched or changed recently
+  short changed = touch ^ lastTouch;
+  short wanted = touch;
+  for (byte i = 0; i < electrodes; i++) {
+    if (bitRead(changed, i))
+      changeHold[i] = changeHoldReads;
+
+    if (changeHold[i] > 0) {
+      bitSet(wanted, i);
+      changeHold[i]--;
+    }
+  }
+  lastTouch = touch;
+
+  // add neighbours
+  for (byte i = 0; i < neighbours; i++) {
+    wanted |= (wanted << 1) | (wanted >> 1);
+  }
+
+  // 0xff forces a full read (first read or refresh()), even if periodic full reads are disabled
+  bool full = readsSinceRefresh == 0xff;
+  if (!full && fullRefreshInterval != 0 && ++readsSinceRefresh >= fullRefreshInterval)
+    full = true;
+  if (full) {
+    wanted = electrodeMask;
+    readsSinceRefresh = 0;
+  }
+
+  wanted &= electrodeMask;
+  freshMask = wanted;
+
+  byte starts[7];
+  byte counts[7];
+  byte bursts = plan(wanted, starts, counts);
+
+  for (byte i = 0; i < bursts; i++) {
+    short* data = mpr->readElectrodeData(starts[i], counts[i]);
+    memcpy(&electrodeData[starts[i]], data, counts[i] * sizeof(short));
+  }
+
+  return touch;
+}
+
+
+// Plans burst reads covering the electrodes in mask.
+// Returns the number of bursts, with their first electrodes and counts in starts and counts (up to 7 each).
+//
+// Each burst costs transactionOverhead plus 2 bytes per electrode, so a gap between two runs of wanted electrodes
+// is worth reading through if it's cheaper than starting a new transaction.
+// Gaps are independent, so deciding each one separately gives the cheapest plan.
+byte mpr121AdaptiveReader::plan(short mask, byte* starts, byte* counts) {
+  byte bursts = 0;
+  byte i = 0;
+
+  while (i < 13) {
+    if (!bitRead(mask, i)) {
+      i++;
+      continue;
+    }
+
+    // start a burst and extend it over wanted electrodes and cheap gaps
+    byte start = i;
+    byte end = i; // last wanted electrode in the burst
+    for (i++; i < 13; i++) {
+      if (!bitRead(mask, i))
+        continue;
+
+      byte gap = i - end - 1;
+      if (gap * 2 > transactionOverhead)
+        break;
+
+      end = i;
+    }
+
+    starts[bursts] = start;
+    counts[bursts] = end - start + 1;
+    bursts++;
+    i = end + 1;
+  }
+
+  return bursts;
+}
+
+#endif // MPR121_FEATURE_ANALOG
@@ -0,0 +1,80 @@
+/** \file QuickMpr121Adaptive.h
+ * adaptive analog data reads for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+#if MPR121_FEATURE_ANALOG
+
+
+/**
+ * Reads analog data only for electrodes that matter.
+ *
+ * Each read() fetches the touch status first, then reads data for touched and recently changed electrodes (plus neighbours).
+ * Reads are planned to minimise modelled bus cost -- nearby electrodes are combined into one burst when that's cheaper than separate transactions.
+ * All electrodes are refreshed periodically so untouched data doesn't get too stale.
+ */
+class mpr121AdaptiveReader {
+private:
+  mpr121* mpr; ///< Device from constructor
+  byte electrodes; ///< Number of electrodes from constructor
+  short electrodeMask; ///< Bitmask of all electrodes from constructor
+  short lastTouch; ///< Touch state from the last read
+  short freshMask; ///< Electrodes updated in the last read
+  byte changeHold[13]; ///< Remaining reads to keep reading each electrode after its touch state changed
+  byte readsSinceRefresh; ///< Number of reads since all electrodes were read
+  short electrodeData[13]; ///< Latest analog data for each electrode
+
+public:
+  /**
+   * Creates an adaptive reader for an mpr121.
+   *
+   * \param mpr         The device to read (start it separately).
+   * \param electrodes  Number of electrodes in use (the same as passed to mpr121::start(), or 13 to include ELEPROX).
+   */
+  mpr121AdaptiveReader(mpr121 &mpr, byte electrodes = 12);
+
+  byte neighbours; ///< Also read this many electrodes either side of touched/changed electrodes (for slider interpolation)
+  byte changeHoldReads; ///< Keep reading an electrode for this many reads after its touch state changes
+  byte fullRefreshInterval; ///< Read all electrodes every this many reads (0 disables periodic full refreshes, but the first read and refresh() still read everything)
+  byte transactionOverhead; ///< Modelled cost of starting a read transaction, in data bytes (about 4 for AVR Wire, more for OS-level I2C drivers)
+
+  /**
+   * Reads touch state, then analog data for the electrodes that need it.
+   * Returns the 13 touch state bits (same as mpr121::readTouchState()).
+   */
+  short read();
+
+  /**
+   * Gets the latest analog data for all 13 electrodes.
+   * Electrodes that weren't read recently keep their previous value.
+   */
+  short* getData() {
+    return electrodeData;
+  }
+
+  /**
+   * Gets the bitmask of electrodes whose data was updated by the last read().
+   */
+  short getFreshMask() {
+    return freshMask;
+  }
+
+  /**
+   * Plans burst reads covering the electrodes in mask.
+   * Returns the number of bursts, with their first electrodes and counts in starts and counts (up to 7 each).
+   */
+  byte plan(short mask, byte* starts, byte* counts);
+
+  /**
+   * Forces all electrodes to be read on the next read().
+   */
+  void refresh() {
+    readsSinceRefresh = 0xff;
+  }
+};
+
+#endif // MPR121_FEATURE_ANALOG
@@ -0,0 +1,160 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * I2C bus bandwidth budgeting.
+ * More info in QuickMpr121Budget.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Budget.h"
+
+#if MPR121_FEATURE_BUDGET
+
+// Creates a bus budget.
+// budget: Bus time that budgeted traffic may use, in μs per second (for example 250000 allows 25% of the bus).
+// busClock: The I2C clock frequency (Hz), used to model transaction times.
+mpr121BusBudget::mpr121BusBudget(unsigned long budget, unsigned long busClock)
+{
+  this->busClock = busClock ? busClock : 100000;
+  capacity = budget / 10;
+  maxWaitMicros = 20000;
+  setBudget(budget);
+
+  tokens = capacity;
+  lastRefillMicros = micros();
+  deferredCount = 0;
+}
+
+
+// Changes the budget (μs of bus time per second).
+// capacity isn't changed.
+void mpr121BusBudget::setBudget(unsigned long budget) {
+  if (budget > 1000000)
+    budget = 1000000;
+
+  // refilling in whole 4096μs ticks keeps the math in 32 bits (budget * 4096 < 2^32)
+  refillPerTick = (budget * 4096 + 500000) / 1000000;
+  if (refillPerTick == 0)
+    refillPerTick = 1;
+}
+
+
+// Adds tokens for the time elapsed since the last refill.
+void mpr121BusBudget::refill() {
+  unsigned long ticks = (micros() - lastRefillMicros) >> 12;
+  if (ticks == 0)
+    return;
+
+  lastRefillMicros += ticks << 12; // keep the partial tick for next time
+
+  if (ticks >= (capacity << 1) / refillPerTick + 1)
+    tokens = capacity; // long enough to fill from empty (avoids overflowing below)
+  else {
+    tokens += ticks * refillPerTick;
+    if (tokens > (long)capacity)
+      tokens = capacity;
+  }
+}
+
+
+// Gets the least tokens that must remain after a transaction of a priority class.
+long mpr121BusBudget::getFloor(mpr121BusPriority priority) {
+  switch (priority) {
+    case MPR_PRIORITY_TOUCH:
+      return -(long)capacity;
+    case MPR_PRIORITY_ANALOG:
+      return 0;
+    case MPR_PRIORITY_LED:
+      return capacity >> 2;
+    default:
+      return capacity >> 1;
+  }
+}
+
+
+// Gets the modelled bus time (μs) of one transaction.
+// count: Number of register bytes read or written.
+// read: Whether it's a read (which needs a repeated start and another address byte).
+unsigned long mpr121BusBudget::getTransactionMicros(byte count, bool read) {
+  // 9 clocks per byte (8 bits + ACK), plus about one clock each for start and stop
+  // writes: address, register, data
+  // reads: address, register, repeated start, address, data
+  unsigned long bits = 9UL * (2 + count) + 2;
+  if (read)
+    bits += 9 + 1;
+
+  return (bits * 1000000 + busClock - 1) / busClock;
+}
+
+
+// Takes cost tokens if the bucket can pay for a transaction of priority without going below its floor.
+// Unlike tryAcquire, failures aren't counted as deferred.
+bool mpr121BusBudget::take(mpr121BusPriority priority, unsigned long cost) {
+  refill();
+
+  if (priority == MPR_PRIORITY_TOUCH) {
+    charge(cost);
+    return true;
+  }
+
+  if (tokens - (long)cost < getFloor(priority))
+    return false;
+
+  tokens -= cost;
+  return true;
+}
+
+
+// Takes cost tokens if the bucket can pay for a transaction of priority without going below its floor.
+// Returns false (and takes nothing) if the transaction should be deferred.
+bool mpr121BusBudget::tryAcquire(mpr121BusPriority priority, unsigned long cost) {
+  if (take(priority, cost))
+    return true;
+
+  deferredCount++;
+  return false;
+}
+
+
+// Takes cost tokens, waiting first (up to maxWaitMicros) if the bucket can't pay for a transaction of priority yet.
+// Call this before other transactions on the bus so they're budgeted too.
+void mpr121BusBudget::acquire(mpr121BusPriority priority, unsigned long cost) {
+  if (tryAcquire(priority, cost))
+    return;
+
+  // wait for enough whole ticks to cover the shortfall
+  unsigned long shortfall = getFloor(priority) + (long)cost - tokens;
+  unsigned long wait = (shortfall / refillPerTick + 1) << 12;
+  wait -= micros() - lastRefillMicros; // the current tick has already started
+  if (wait > maxWaitMicros)
+    wait = maxWaitMicros;
+
+  delay(wait / 1000);
+  delayMicroseconds(wait % 1000);
+
+  refill();
+  charge(cost);
+}
+
+
+// Takes cost tokens without waiting (for traffic that has already happened or can't wait).
+// The bucket isn't overdrawn below -capacity.
+void mpr121BusBudget::charge(unsigned long cost) {
+  if (cost > capacity << 1)
+    cost = capacity << 1;
+
+  tokens -= cost;
+  if (tokens < -(long)capacity)
+    tokens = -(long)capacity;
+}
+
+
+// Gets the bus time (μs) currently available (negative if overdrawn).
+long mpr121BusBudget::getAvailable() {
+  refill();
+  return tokens;
+}
+
+#endif // MPR121_FEATURE_BUDGET
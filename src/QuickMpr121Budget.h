@@ -0,0 +1,114 @@
+/** \file QuickMpr121Budget.h
+ * I2C bus bandwidth budgeting for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+#if MPR121_FEATURE_BUDGET
+
+/**
+ * Limits how much of an I2C bus's time MPR121 traffic can use, so other devices on the bus (IMUs, EEPROMs, etc.) get predictable latency.
+ *
+ * This is a token bucket counted in modelled bus time: every transaction costs the μs it keeps the bus busy (from its byte count and busClock),
+ * and the bucket refills at budget μs per second, up to capacity.
+ * Share one budget between all mpr121s on a bus (see mpr121::setBusBudget).
+ * Traffic from other devices can be counted with acquire() or charge().
+ *
+ * Each priority class (mpr121BusPriority) has a floor that must remain after a transaction:
+ *  - MPR_PRIORITY_TOUCH is never delayed, and can overdraw the bucket down to -capacity
+ *  - MPR_PRIORITY_ANALOG waits until the bucket can pay without going negative
+ *  - MPR_PRIORITY_LED needs capacity/4 left over -- LED writes are coalesced by the mpr121 instead of waiting
+ *  - MPR_PRIORITY_DIAGNOSTIC needs capacity/2 left over
+ *
+ * So when the bus is busy, lower priority traffic is delayed first and touch reads keep their latency.
+ * Waits never exceed maxWaitMicros, which bounds the extra latency of any one transaction.
+ *
+ * Not thread-safe -- use it from the thread that owns the bus.
+ */
+class mpr121BusBudget {
+  friend class mpr121;
+
+private:
+  unsigned long busClock; ///< Bus clock from constructor (Hz)
+  unsigned long refillPerTick; ///< Tokens added every 4096μs
+  long tokens; ///< Available bus time (μs), negative if touch reads have overdrawn the bucket
+  unsigned long lastRefillMicros; ///< Time of the last whole refill tick
+  unsigned long deferredCount; ///< Number of transactions that had to wait or be coalesced
+
+  /**
+   * Adds tokens for the time elapsed since the last refill.
+   */
+  void refill();
+
+  /**
+   * Gets the least tokens that must remain after a transaction of a priority class.
+   */
+  long getFloor(mpr121BusPriority priority);
+
+  /**
+   * Takes cost tokens if the bucket can pay for a transaction of priority without going below its floor.
+   * Unlike tryAcquire, failures aren't counted as deferred.
+   */
+  bool take(mpr121BusPriority priority, unsigned long cost);
+
+public:
+  /**
+   * Creates a bus budget.
+   *
+   * \param budget    Bus time that budgeted traffic may use, in μs per second (for example 250000 allows 25% of the bus).
+   * \param busClock  The I2C clock frequency (Hz), used to model transaction times.
+   */
+  mpr121BusBudget(unsigned long budget, unsigned long busClock = 100000);
+
+  unsigned long capacity; ///< Most bus time (μs) that can be saved up while the bus is idle, which sets the largest burst (default budget / 10)
+  unsigned long maxWaitMicros; ///< Longest a transaction will be delayed before going ahead anyway (default 20000)
+
+  /**
+   * Changes the budget (μs of bus time per second).
+   * capacity isn't changed.
+   */
+  void setBudget(unsigned long budget);
+
+  /**
+   * Gets the modelled bus time (μs) of one transaction.
+   *
+   * \param count  Number of register bytes read or written.
+   * \param read   Whether it's a read (which needs a repeated start and another address byte).
+   */
+  unsigned long getTransactionMicros(byte count, bool read);
+
+  /**
+   * Takes cost tokens if the bucket can pay for a transaction of priority without going below its floor.
+   * Returns false (and takes nothing) if the transaction should be deferred.
+   */
+  bool tryAcquire(mpr121BusPriority priority, unsigned long cost);
+
+  /**
+   * Takes cost tokens, waiting first (up to maxWaitMicros) if the bucket can't pay for a transaction of priority yet.
+   * Call this before other transactions on the bus so they're budgeted too.
+   */
+  void acquire(mpr121BusPriority priority, unsigned long cost);
+
+  /**
+   * Takes cost tokens without waiting (for traffic that has already happened or can't wait).
+   * The bucket isn't overdrawn below -capacity.
+   */
+  void charge(unsigned long cost);
+
+  /**
+   * Gets the bus time (μs) currently available (negative if overdrawn).
+   */
+  long getAvailable();
+
+  /**
+   * Gets the number of transactions that have had to wait or be coalesced.
+   */
+  unsigned long getDeferredCount() {
+    return deferredCount;
+  }
+};
+
+#endif // MPR121_FEATURE_BUDGET
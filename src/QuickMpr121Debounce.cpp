@@ -0,0 +1,146 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Per-electrode software debounce and hysteresis.
+ * More info in QuickMpr121Debounce.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Debounce.h"
+
+#if MPR121_FEATURE_ANALOG
+
+// Creates a debouncer with the same thresholds as a new mpr121 and no debounce.
+// electrodes: Number of electrodes to use, starting from ELE0 (13 includes ELEPROX).
+mpr121Debouncer::mpr121Debouncer(byte electrodes)
+{
+  this->electrodes = electrodes > 13 ? 13 : electrodes;
+
+  for (byte i = 0; i < 13; i++) {
+    touchThresholds[i] = 0x0f;
+    releaseThresholds[i] = 0x0a;
+  }
+
+  for (byte k = 0; k < 4; k++) {
+    touchLimit[k] = 0;
+    releaseLimit[k] = 0;
+  }
+
+  reset();
+}
+
+
+// Sets touch and release thresholds for an electrode.
+// Use a lower release threshold than touch threshold for hysteresis.
+void mpr121Debouncer::setThresholds(byte electrode, byte touch, byte release) {
+  if (electrode > 12)
+    return;
+
+  touchThresholds[electrode] = touch;
+  releaseThresholds[electrode] = release;
+}
+
+
+// Sets how many extra consecutive updates a touch or release must be seen for before an electrode changes state (max MPR121_DEBOUNCE_MAX).
+void mpr121Debouncer::setDebounce(byte electrode, byte touch, byte release) {
+  if (electrode > 12)
+    return;
+
+  if (touch > MPR121_DEBOUNCE_MAX)
+    touch = MPR121_DEBOUNCE_MAX;
+  if (release > MPR121_DEBOUNCE_MAX)
+    release = MPR121_DEBOUNCE_MAX;
+
+  for (byte k = 0; k < 4; k++) {
+    bitWrite(touchLimit[k], electrode, bitRead(touch, k));
+    bitWrite(releaseLimit[k], electrode, bitRead(release, k));
+  }
+}
+
+
+// Releases all electrodes and clears debounce counts.
+void mpr121Debouncer::reset() {
+  for (byte k = 0; k < 4; k++) {
+    counter[k] = 0;
+  }
+  state = 0;
+}
+
+
+// Updates touch state from delta values (filtered - (baseline << 2), as returned by mpr121::readElectrodeDelta()) for each electrode.
+// Returns the debounced touch state bits.
+short mpr121Debouncer::update(const short* delta) {
+  // threshold comparisons are the only per-electrode work
+  unsigned short over = 0, under = 0;
+  for (byte i = 0; i < electrodes; i++) {
+    short level = -delta[i]; // baseline - filtered
+    if (level > touchThresholds[i])
+      over |= 1 << i;
+    if (level < releaseThresholds[i])
+      under |= 1 << i;
+  }
+
+  // electrodes that want to change state, and the debounce count each one needs
+  unsigned short pending = (~state & over) | (state & under);
+  unsigned short limit[4];
+  for (byte k = 0; k < 4; k++) {
+    limit[k] = (~state & touchLimit[k]) | (state & releaseLimit[k]);
+  }
+
+  // counter >= limit, compared from the top bit down
+  unsigned short greater = 0, equal = 0xffff;
+  for (byte k = 4; k-- > 0;) {
+    greater |= equal & counter[k] & ~limit[k];
+    equal &= ~(counter[k] ^ limit[k]);
+  }
+  unsigned short change = pending & (greater | equal);
+
+  state ^= change;
+
+  // count up electrodes that are still pending (saturating), and clear the rest
+  unsigned short count = pending & ~change;
+  unsigned short carry = count & ~(counter[0] & counter[1] & counter[2] & counter[3]);
+  for (byte k = 0; k < 4; k++) {
+    unsigned short next = counter[k] & carry;
+    counter[k] = (counter[k] ^ carry) & count;
+    carry = next;
+  }
+
+  return state;
+}
+
+
+// Updates touch state from a frame.
+// Returns the debounced touch state bits.
+short mpr121Debouncer::update(const mpr121Frame &frame) {
+  short delta[13];
+  for (byte i = 0; i < electrodes; i++) {
+    delta[i] = frame.electrodeData[i] - (frame.electrodeBaseline[i] << 2);
+  }
+  return update(delta);
+}
+
+
+// Updates touch state from a raw frame.
+// Returns the debounced touch state bits.
+short mpr121Debouncer::update(const mpr121RawFrame &frame) {
+  short delta[13];
+  for (byte i = 0; i < electrodes; i++) {
+    delta[i] = frame.delta(i);
+  }
+  return update(delta);
+}
+
+
+// Reads delta values from an mpr121 and updates touch state.
+// Call this regularly instead of mpr121::readTouchState().
+// Returns the debounced touch state bits.
+short mpr121Debouncer::update(mpr121 &mpr) {
+  if (electrodes == 0)
+    return state;
+  return update(mpr.readElectrodeDelta(0, electrodes));
+}
+
+#endif // MPR121_FEATURE_ANALOG
@@ -0,0 +1,99 @@
+/** \file QuickMpr121Debounce.h
+ * per-electrode software debounce and hysteresis for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+#if MPR121_FEATURE_ANALOG
+
+/// Highest debounce count supported by mpr121Debouncer
+#define MPR121_DEBOUNCE_MAX 15
+
+/**
+ * Detects touches from delta data with thresholds and debounce counts set separately for each electrode.
+ *
+ * The MPR121 only has one touch and one release debounce count (max 7) for all electrodes,
+ * so fast keys and slow noisy pads have to share a setting.
+ * With this, set the hardware debounce to 0 and give only the electrodes that need it extra debounce.
+ *
+ * An electrode becomes touched when baseline - filtered data has been above its touch threshold for debounce touch + 1 consecutive updates,
+ * and released when it has been below its release threshold for debounce release + 1 updates (the gap between the thresholds is the hysteresis).
+ *
+ * Debounce counters for all electrodes are stored as bit planes (bit n of plane k is bit k of electrode n's counter),
+ * so counting, resetting, and comparing against each electrode's limit is done for all 13 electrodes at once with a few bitwise operations.
+ *
+ * The MPR121's own touch state still controls baseline tracking while touched (NHDtouched etc.),
+ * so keep its thresholds at or below the software ones.
+ */
+class mpr121Debouncer {
+private:
+  byte electrodes; ///< Number of electrodes from constructor
+  byte touchThresholds[13]; ///< Touch thresholds for each electrode
+  byte releaseThresholds[13]; ///< Release thresholds for each electrode
+  unsigned short touchLimit[4]; ///< Bit planes of debounce touch counts
+  unsigned short releaseLimit[4]; ///< Bit planes of debounce release counts
+  unsigned short counter[4]; ///< Bit planes of consecutive updates each electrode has wanted to change state
+  unsigned short state; ///< Debounced touch state
+
+public:
+  /**
+   * Creates a debouncer with the same thresholds as a new mpr121 and no debounce.
+   *
+   * \param electrodes  Number of electrodes to use, starting from ELE0 (13 includes ELEPROX).
+   */
+  mpr121Debouncer(byte electrodes = 12);
+
+  /**
+   * Sets touch and release thresholds for an electrode.
+   * Use a lower release threshold than touch threshold for hysteresis.
+   */
+  void setThresholds(byte electrode, byte touch, byte release);
+
+  /**
+   * Sets how many extra consecutive updates a touch or release must be seen for before an electrode changes state (max MPR121_DEBOUNCE_MAX).
+   */
+  void setDebounce(byte electrode, byte touch, byte release);
+
+  /**
+   * Releases all electrodes and clears debounce counts.
+   */
+  void reset();
+
+  /**
+   * Updates touch state from delta values (filtered - (baseline << 2), as returned by mpr121::readElectrodeDelta()) for each electrode.
+   * Returns the debounced touch state bits.
+   */
+  short update(const short* delta);
+
+  /**
+   * Updates touch state from a frame.
+   * Returns the debounced touch state bits.
+   */
+  short update(const mpr121Frame &frame);
+
+  /**
+   * Updates touch state from a raw frame.
+   * Returns the debounced touch state bits.
+   */
+  short update(const mpr121RawFrame &frame);
+
+  /**
+   * Reads delta values from an mpr121 and updates touch state.
+   * Call this regularly instead of mpr121::readTouchState().
+   *
+   * Returns the debounced touch state bits.
+   */
+  short update(mpr121 &mpr);
+
+  /**
+   * Gets the debounced touch state bits from the last update.
+   */
+  short getTouched() {
+    return state;
+  }
+};
+
+#endif // MPR121_FEATURE_ANALOG
@@ -0,0 +1,261 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Bulk decoding of raw register frames.
+ * More info in QuickMpr121Decode.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Decode.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+  #define MPR121_DECODE_HAVE_SSE2 1
+  #include <emmintrin.h>
+
+  #if defined(__GNUC__)
+    // AVX2 code is compiled with a target attribute and only used if the CPU supports it
+    #define MPR121_DECODE_HAVE_AVX2 1
+    #include <immintrin.h>
+  #endif
+#endif
+
+
+// register offsets within a raw frame
+#define FILTERED_OFFSET 0x04
+#define BASELINE_OFFSET 0x1e
+#define FRAME_LEN 0x2b
+
+
+// Stores a value for one frame if the output buffer is set.
+static inline void storeScalar(int16_t* const* dest, uint8_t electrode, size_t index, int16_t value) {
+  if (dest[electrode])
+    dest[electrode][index] = value;
+}
+
+// Decodes frames one at a time using the same math as mpr121::readElectrodeData().
+static void decodeScalar(const uint8_t* frames, size_t stride, size_t first, size_t count, const mpr121DecodedFrames &out) {
+  for (size_t n = first; n < first + count; n++) {
+    const uint8_t* rawdata = frames + n * stride;
+
+    for (uint8_t i = 0; i < 13; i++) {
+      int16_t filtered = rawdata[FILTERED_OFFSET + i*2] | ((rawdata[FILTERED_OFFSET + i*2 + 1] & 0b00000011) << 8);
+      int16_t baseline = rawdata[BASELINE_OFFSET + i] << 2;
+
+      storeScalar(out.filtered, i, n, filtered);
+      storeScalar(out.baseline, i, n, baseline);
+      storeScalar(out.delta, i, n, filtered - baseline);
+    }
+  }
+}
+
+
+#if MPR121_DECODE_HAVE_SSE2
+  // Transposes an 8x8 matrix of 16-bit values (rows become columns).
+  static inline void transpose8x8(__m128i* r) {
+    __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+    r[0] = _mm_unpacklo_epi64(b0, b4);
+    r[1] = _mm_unpackhi_epi64(b0, b4);
+    r[2] = _mm_unpacklo_epi64(b1, b5);
+    r[3] = _mm_unpackhi_epi64(b1, b5);
+    r[4] = _mm_unpacklo_epi64(b2, b6);
+    r[5] = _mm_unpackhi_epi64(b2, b6);
+    r[6] = _mm_unpacklo_epi64(b3, b7);
+    r[7] = _mm_unpackhi_epi64(b3, b7);
+  }
+
+  // Transposes 8 frames worth of values for 8 electrodes and stores them.
+  static inline void storeTransposed(__m128i* rows, int16_t* const* dest, uint8_t firstElectrode, uint8_t electrodes, size_t index) {
+    transpose8x8(rows);
+    for (uint8_t i = 0; i < electrodes; i++) {
+      if (dest[firstElectrode + i])
+        _mm_storeu_si128((__m128i*)&dest[firstElectrode + i][index], rows[i]);
+    }
+  }
+
+  // Decodes blocks of 8 frames using SSE2.
+  // Each frame is decoded into vectors of 8 electrodes, then vectors are transposed so each holds 8 frames for one electrode.
+  static void decodeSSE2(const uint8_t* frames, size_t stride, size_t count, const mpr121DecodedFrames &out) {
+    const __m128i mask = _mm_set1_epi16(0x03ff);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t n = 0;
+    for ( ; n + 8 <= count; n += 8) {
+      __m128i filteredLo[8], filteredHi[8], baselineLo[8], baselineHi[8], deltaLo[8], deltaHi[8];
+
+      for (uint8_t f = 0; f < 8; f++) {
+        const uint8_t* rawdata = frames + (n + f) * stride;
+
+        filteredLo[f] = _mm_and_si128(_mm_loadu_si128((const __m128i*)(rawdata + FILTERED_OFFSET)), mask); // ELE0-ELE7
+        filteredHi[f] = _mm_and_si128(_mm_loadu_si128((const __m128i*)(rawdata + FILTERED_OFFSET + 16)), mask); // ELE8-ELEPROX (+3 unused)
+
+        // load ending at the last frame byte to avoid reading past the end of the final frame, then shift baselines down
+        __m128i baselineBytes = _mm_srli_si128(_mm_loadu_si128((const __m128i*)(rawdata + FRAME_LEN - 16)), BASELINE_OFFSET - (FRAME_LEN - 16));
+        baselineLo[f] = _mm_slli_epi16(_mm_unpacklo_epi8(baselineBytes, zero), 2);
+        baselineHi[f] = _mm_slli_epi16(_mm_unpackhi_epi8(baselineBytes, zero), 2);
+
+        deltaLo[f] = _mm_sub_epi16(filteredLo[f], baselineLo[f]);
+        deltaHi[f] = _mm_sub_epi16(filteredHi[f], baselineHi[f]);
+      }
+
+      storeTransposed(filteredLo, out.filtered, 0, 8, n);
+      storeTransposed(filteredHi, out.filtered, 8, 5, n);
+      storeTransposed(baselineLo, out.baseline, 0, 8, n);
+      storeTransposed(baselineHi, out.baseline, 8, 5, n);
+      storeTransposed(deltaLo, out.delta, 0, 8, n);
+      storeTransposed(deltaHi, out.delta, 8, 5, n);
+    }
+
+    decodeScalar(frames, stride, n, count - n, out);
+  }
+#endif // MPR121_DECODE_HAVE_SSE2
+
+
+#if MPR121_DECODE_HAVE_AVX2
+  // Transposes two 8x8 matrices of 16-bit values at once (one in each 128-bit lane).
+  __attribute__((target("avx2")))
+  static inline void transpose8x8x2(__m256i* r) {
+    __m256i a0 = _mm256_unpacklo_epi16(r[0], r[1]);
+    __m256i a1 = _mm256_unpackhi_epi16(r[0], r[1]);
+    __m256i a2 = _mm256_unpacklo_epi16(r[2], r[3]);
+    __m256i a3 = _mm256_unpackhi_epi16(r[2], r[3]);
+    __m256i a4 = _mm256_unpacklo_epi16(r[4], r[5]);
+    __m256i a5 = _mm256_unpackhi_epi16(r[4], r[5]);
+    __m256i a6 = _mm256_unpacklo_epi16(r[6], r[7]);
+    __m256i a7 = _mm256_unpackhi_epi16(r[6], r[7]);
+
+    __m256i b0 = _mm256_unpacklo_epi32(a0, a2);
+    __m256i b1 = _mm256_unpackhi_epi32(a0, a2);
+    __m256i b2 = _mm256_unpacklo_epi32(a1, a3);
+    __m256i b3 = _mm256_unpackhi_epi32(a1, a3);
+    __m256i b4 = _mm256_unpacklo_epi32(a4, a6);
+    __m256i b5 = _mm256_unpackhi_epi32(a4, a6);
+    __m256i b6 = _mm256_unpacklo_epi32(a5, a7);
+    __m256i b7 = _mm256_unpackhi_epi32(a5, a7);
+
+    r[0] = _mm256_unpacklo_epi64(b0, b4);
+    r[1] = _mm256_unpackhi_epi64(b0, b4);
+    r[2] = _mm256_unpacklo_epi64(b1, b5);
+    r[3] = _mm256_unpackhi_epi64(b1, b5);
+    r[4] = _mm256_unpacklo_epi64(b2, b6);
+    r[5] = _mm256_unpackhi_epi64(b2, b6);
+    r[6] = _mm256_unpacklo_epi64(b3, b7);
+    r[7] = _mm256_unpackhi_epi64(b3, b7);
+  }
+
+  // Transposes 8 frames worth of values for all electrodes and stores them.
+  // After transposing, the low lane of row i holds electrode i and the high lane holds electrode i+8.
+  __attribute__((target("avx2")))
+  static inline void storeTransposed(__m256i* rows, int16_t* const* dest, size_t index) {
+    transpose8x8x2(rows);
+    for (uint8_t i = 0; i < 8; i++) {
+      if (dest[i])
+        _mm_storeu_si128((__m128i*)&dest[i][index], _mm256_castsi256_si128(rows[i]));
+      if (i + 8 < 13 && dest[i + 8])
+        _mm_storeu_si128((__m128i*)&dest[i + 8][index], _mm256_extracti128_si256(rows[i], 1));
+    }
+  }
+
+  // Decodes blocks of 8 frames using AVX2.
+  // Same as decodeSSE2, but each vector holds all 13 electrodes for a frame.
+  __attribute__((target("avx2")))
+  static void decodeAVX2(const uint8_t* frames, size_t stride, size_t count, const mpr121DecodedFrames &out) {
+    const __m256i mask = _mm256_set1_epi16(0x03ff);
+
+    size_t n = 0;
+    for ( ; n + 8 <= count; n += 8) {
+      __m256i filtered[8], baseline[8], delta[8];
+
+      for (uint8_t f = 0; f < 8; f++) {
+        const uint8_t* rawdata = frames + (n + f) * stride;
+
+        filtered[f] = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(rawdata + FILTERED_OFFSET)), mask);
+
+        __m128i baselineBytes = _mm_srli_si128(_mm_loadu_si128((const __m128i*)(rawdata + FRAME_LEN - 16)), BASELINE_OFFSET - (FRAME_LEN - 16));
+        baseline[f] = _mm256_slli_epi16(_mm256_cvtepu8_epi16(baselineBytes), 2);
+
+        delta[f] = _mm256_sub_epi16(filtered[f], baseline[f]);
+      }
+
+      storeTransposed(filtered, out.filtered, n);
+      storeTransposed(baseline, out.baseline, n);
+      storeTransposed(delta, out.delta, n);
+    }
+
+    decodeScalar(frames, stride, n, count - n, out);
+  }
+#endif // MPR121_DECODE_HAVE_AVX2
+
+
+// Checks if a decoder implementation is supported on this CPU.
+bool mpr121DecodeSupported(mpr121DecodeImpl impl) {
+  switch (impl) {
+    case MPR_DECODE_AUTO:
+    case MPR_DECODE_SCALAR:
+      return true;
+
+    #if MPR121_DECODE_HAVE_SSE2
+      case MPR_DECODE_SSE2:
+        return true;
+    #endif
+
+    #if MPR121_DECODE_HAVE_AVX2
+      case MPR_DECODE_AVX2:
+        return __builtin_cpu_supports("avx2");
+    #endif
+
+    default:
+      return false;
+  }
+}
+
+// Decodes raw register frames into structure-of-arrays buffers.
+void mpr121DecodeFrames(const uint8_t* frames, size_t stride, size_t count, const mpr121DecodedFrames &out, mpr121DecodeImpl impl) {
+  if (impl == MPR_DECODE_AUTO) {
+    if (mpr121DecodeSupported(MPR_DECODE_AVX2))
+      impl = MPR_DECODE_AVX2;
+    else if (mpr121DecodeSupported(MPR_DECODE_SSE2))
+      impl = MPR_DECODE_SSE2;
+    else
+      impl = MPR_DECODE_SCALAR;
+  }
+  else if (!mpr121DecodeSupported(impl)) {
+    impl = MPR_DECODE_SCALAR;
+  }
+
+  switch (impl) {
+    #if MPR121_DECODE_HAVE_AVX2
+      case MPR_DECODE_AVX2:
+        decodeAVX2(frames, stride, count, out);
+        break;
+    #endif
+
+    #if MPR121_DECODE_HAVE_SSE2
+      case MPR_DECODE_SSE2:
+        decodeSSE2(frames, stride, count, out);
+        break;
+    #endif
+
+    default:
+      decodeScalar(frames, stride, 0, count, out);
+      break;
+  }
+}
@@ -0,0 +1,51 @@
+/** \file QuickMpr121Decode.h
+ * bulk decoding of raw register frames for QuickMpr121
+ *
+ * Intended for post-processing recordings on a host (see QuickMpr121Recorder.h), so this doesn't depend on Arduino.h.
+ * Results are bit-exact with the normal mpr121 read functions.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+
+/// possible bulk decoder implementations
+enum mpr121DecodeImpl : uint8_t {
+  MPR_DECODE_AUTO = 0, ///< Use the fastest implementation supported by the CPU
+  MPR_DECODE_SCALAR = 1, ///< Portable scalar code
+  MPR_DECODE_SSE2 = 2, ///< SSE2 (x86 only)
+  MPR_DECODE_AVX2 = 3, ///< AVX2 (x86 only, requires CPU support)
+};
+
+
+/**
+ * Structure-of-arrays output for mpr121DecodeFrames.
+ *
+ * Each non-null pointer must have space for one value per decoded frame.
+ * Leave pointers null to skip decoding that data for an electrode.
+ */
+struct mpr121DecodedFrames {
+  int16_t* filtered[13]; ///< Filtered analog data for ELE0-ELE11 and ELEPROX (same as mpr121::readElectrodeData())
+  int16_t* baseline[13]; ///< Baselines shifted left by 2 to match filtered data (mpr121::readElectrodeBaseline() << 2)
+  int16_t* delta[13]; ///< filtered - baseline
+};
+
+
+/**
+ * Decodes raw register frames (as read by mpr121::readRawFrame()) into structure-of-arrays buffers.
+ *
+ * \param frames  Pointer to register 0x00 of the first frame.
+ * \param stride  Distance in bytes between frames (use MPR121_RAW_FRAME_LEN for packed frames or sizeof(mpr121Record) for recordings).
+ * \param count   Number of frames to decode.
+ * \param out     Output buffers.
+ * \param impl    Implementation to use. If the requested implementation isn't supported, the scalar one is used.
+ */
+void mpr121DecodeFrames(const uint8_t* frames, size_t stride, size_t count, const mpr121DecodedFrames &out, mpr121DecodeImpl impl = MPR_DECODE_AUTO);
+
+/**
+ * Checks if a decoder implementation is supported on this CPU.
+ */
+bool mpr121DecodeSupported(mpr121DecodeImpl impl);
@@ -0,0 +1,187 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Bus discovery and device probing.
+ * More info in QuickMpr121Discover.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Discover.h"
+
+#if MPR121_DISCOVER_THREADS
+  #include <thread>
+  #include <vector>
+#endif
+
+// Creates a discovery with default settings (no mux, no resets).
+mpr121Discovery::mpr121Discovery()
+{
+  muxAddress = 0;
+  muxChannels = 0xff;
+  resetConfigured = false;
+}
+
+
+// Checks if a device acknowledges its address (zero-length write).
+bool mpr121Discovery::probe(TwoWire* wire, byte address) {
+  wire->beginTransmission(address);
+  return wire->endTransmission() == 0;
+}
+
+
+// Reads consecutive registers.
+// Returns false if the device didn't send them all.
+bool mpr121Discovery::readRegisters(TwoWire* wire, byte address, mpr121Register reg, byte* dest, byte count) {
+  wire->beginTransmission(address);
+  wire->write(reg);
+  if (wire->endTransmission(false) != 0)
+    return false;
+
+  wire->requestFrom(address, count, (byte)true);
+
+  byte readnum = 0;
+  while (wire->available() && readnum < count)
+  {
+    dest[readnum] = wire->read();
+    readnum++;
+  }
+
+  return readnum == count;
+}
+
+
+// Selects mux channels (bit n enables channel n).
+// Returns false if the mux didn't acknowledge.
+bool mpr121Discovery::selectMux(TwoWire* wire, byte channels) {
+  wire->beginTransmission(muxAddress);
+  wire->write(channels);
+  return wire->endTransmission() == 0;
+}
+
+
+// Checks if a responding device is an MPR121.
+mpr121DeviceState mpr121Discovery::identify(TwoWire* wire, byte address) {
+  // AFE, filter, and electrode configuration should have their power-on values (0x10, 0x24, 0x00)
+  byte regs[3];
+  if (!readRegisters(wire, address, MPRREG_AFE_CONFIG, regs, 3))
+    return MPR_DEVICE_UNKNOWN;
+  if (regs[0] == 0x10 && regs[1] == 0x24 && regs[2] == 0x00)
+    return MPR_DEVICE_IDENTIFIED;
+
+  if (!resetConfigured)
+    return MPR_DEVICE_CONFIGURED;
+
+  wire->beginTransmission(address);
+  wire->write(MPRREG_SOFT_RESET);
+  wire->write(0x63);
+  wire->endTransmission();
+  delay(1);
+
+  if (!readRegisters(wire, address, MPRREG_AFE_CONFIG, regs, 3))
+    return MPR_DEVICE_UNKNOWN;
+  if (regs[0] == 0x10 && regs[1] == 0x24 && regs[2] == 0x00)
+    return MPR_DEVICE_IDENTIFIED;
+
+  return MPR_DEVICE_UNKNOWN; // still wrong after a reset
+}
+
+
+// Probes MPR121 addresses not in skip (bit 0 is 0x5a), adding responding devices to found.
+// Returns the addresses that responded.
+byte mpr121Discovery::probeAddresses(TwoWire* wire, byte muxChannel, byte skip, mpr121DeviceInfo* found, byte maxDevices, byte &count) {
+  byte responded = 0;
+
+  for (byte i = 0; i < 4; i++) {
+    if (bitRead(skip, i) || !probe(wire, 0x5a + i))
+      continue;
+
+    bitSet(responded, i);
+    if (count >= maxDevices)
+      continue;
+
+    found[count].wire = wire;
+    found[count].address = 0x5a + i;
+    found[count].muxChannel = muxChannel;
+    found[count].state = identify(wire, 0x5a + i);
+    count++;
+  }
+
+  return responded;
+}
+
+
+// Finds devices on one bus (through each mux channel if muxAddress is set).
+// Returns the number of devices written to found (max MPR121_DISCOVER_BUS_MAX, or maxDevices if smaller).
+byte mpr121Discovery::discoverBus(TwoWire* wire, mpr121DeviceInfo* found, byte maxDevices) {
+  byte count = 0;
+
+  // with all mux channels off, only devices directly on the bus respond
+  bool haveMux = muxAddress != 0 && selectMux(wire, 0);
+  byte direct = probeAddresses(wire, MPR121_NO_MUX, 0, found, maxDevices, count);
+
+  if (!haveMux)
+    return count;
+
+  for (byte ch = 0; ch < 8; ch++) {
+    if (!bitRead(muxChannels, ch) || !selectMux(wire, 1 << ch))
+      continue;
+
+    // devices directly on the bus would show up again on every channel
+    probeAddresses(wire, ch, direct, found, maxDevices, count);
+  }
+
+  selectMux(wire, 0);
+  return count;
+}
+
+
+// Finds MPR121s on one or more buses.
+// Devices are listed by bus, then mux channel (devices directly on the bus first), then address.
+// table: Receives the devices found.
+// maxDevices: Size of table.
+// buses: Buses to search (default: just Wire).
+// busCount: Number of buses.
+// Returns the number of devices found (up to maxDevices).
+byte mpr121Discovery::discover(mpr121DeviceInfo* table, byte maxDevices, TwoWire** buses, byte busCount) {
+  TwoWire* defaultBus = &Wire;
+  if (!buses || busCount == 0) {
+    buses = &defaultBus;
+    busCount = 1;
+  }
+
+  #if MPR121_DISCOVER_THREADS
+    if (busCount > 1) {
+      // buses are independent, so probe them all at once and merge the results in bus order
+      std::vector<std::vector<mpr121DeviceInfo>> found(busCount, std::vector<mpr121DeviceInfo>(MPR121_DISCOVER_BUS_MAX));
+      std::vector<byte> counts(busCount);
+      std::vector<std::thread> threads;
+
+      for (byte b = 1; b < busCount; b++) {
+        threads.emplace_back([this, &found, &counts, buses, b]() {
+          counts[b] = discoverBus(buses[b], found[b].data(), MPR121_DISCOVER_BUS_MAX);
+        });
+      }
+      counts[0] = discoverBus(buses[0], found[0].data(), MPR121_DISCOVER_BUS_MAX);
+
+      byte total = 0;
+      for (byte b = 0; b < busCount; b++) {
+        if (b > 0)
+          threads[b - 1].join();
+
+        for (byte i = 0; i < counts[b] && total < maxDevices; i++)
+          table[total++] = found[b][i];
+      }
+
+      return total;
+    }
+  #endif
+
+  byte total = 0;
+  for (byte b = 0; b < busCount; b++) {
+    total += discoverBus(buses[b], table + total, maxDevices - total);
+  }
+
+  return total;
+}
@@ -0,0 +1,101 @@
+/** \file QuickMpr121Discover.h
+ * bus discovery and device probing for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+/// mpr121DeviceInfo::muxChannel for devices that aren't behind a mux
+#define MPR121_NO_MUX 0xff
+
+/// Most devices that can be found on one bus (4 addresses directly on the bus, and on each of 8 mux channels)
+#define MPR121_DISCOVER_BUS_MAX 36
+
+
+/**
+ * A device found by mpr121Discovery.
+ */
+struct mpr121DeviceInfo {
+  TwoWire* wire; ///< Bus the device is on
+  byte address; ///< I2C address (0x5a-0x5d)
+  byte muxChannel; ///< Mux channel that must be selected to reach the device (0-7), or MPR121_NO_MUX
+  mpr121DeviceState state; ///< Whether the device was identified as an MPR121
+};
+
+
+/**
+ * Finds which MPR121s are actually connected, so boards with missing or optional sensors don't have to be configured by hand
+ * and absent devices aren't waited on.
+ *
+ * Each MPR121 address (0x5a-0x5d) is probed with a zero-length write, which absent devices don't acknowledge.
+ * Devices that respond are identified by reading three registers (AFE, filter, and electrode configuration) and checking for their power-on values.
+ * Devices that have already been configured (for example if only the host was reset) can't be identified that way,
+ * so they're reported as MPR_DEVICE_CONFIGURED unless resetConfigured is set.
+ *
+ * Devices behind a TCA9548A-style I2C mux (set muxAddress) are found on each channel too.
+ * The mux is left with all channels off, and selecting the right channel before using a device is up to the caller.
+ *
+ * On Linux hosts, separate buses are probed from parallel threads. Elsewhere they're probed one after another.
+ *
+ * Found devices can be used with `mpr121 mpr(info.address, info.wire);`.
+ */
+class mpr121Discovery {
+private:
+  /**
+   * Finds devices on one bus (through each mux channel if muxAddress is set).
+   * Returns the number of devices written to found (max MPR121_DISCOVER_BUS_MAX, or maxDevices if smaller).
+   */
+  byte discoverBus(TwoWire* wire, mpr121DeviceInfo* found, byte maxDevices);
+
+  /**
+   * Probes MPR121 addresses not in skip (bit 0 is 0x5a), adding responding devices to found.
+   * Returns the addresses that responded.
+   */
+  byte probeAddresses(TwoWire* wire, byte muxChannel, byte skip, mpr121DeviceInfo* found, byte maxDevices, byte &count);
+
+  /**
+   * Checks if a responding device is an MPR121.
+   */
+  mpr121DeviceState identify(TwoWire* wire, byte address);
+
+  /**
+   * Checks if a device acknowledges its address (zero-length write).
+   */
+  static bool probe(TwoWire* wire, byte address);
+
+  /**
+   * Reads consecutive registers.
+   * Returns false if the device didn't send them all.
+   */
+  static bool readRegisters(TwoWire* wire, byte address, mpr121Register reg, byte* dest, byte count);
+
+  /**
+   * Selects mux channels (bit n enables channel n).
+   * Returns false if the mux didn't acknowledge.
+   */
+  bool selectMux(TwoWire* wire, byte channels);
+
+public:
+  /**
+   * Creates a discovery with default settings (no mux, no resets).
+   */
+  mpr121Discovery();
+
+  byte muxAddress; ///< I2C address of a TCA9548A-style mux to search behind (0x70-0x77), or 0 for none (default 0)
+  byte muxChannels; ///< Mux channels to search (bit n is channel n, default 0xff)
+  bool resetConfigured; ///< Soft reset devices that have been configured, so they can be identified (default false -- this stops running devices)
+
+  /**
+   * Finds MPR121s on one or more buses.
+   * Devices are listed by bus, then mux channel (devices directly on the bus first), then address.
+   *
+   * \param table       Receives the devices found.
+   * \param maxDevices  Size of table.
+   * \param buses       Buses to search (default: just Wire).
+   * \param busCount    Number of buses.
+   * \returns           The number of devices found (up to maxDevices).
+   */
+  byte discover(mpr121DeviceInfo* table, byte maxDevices, TwoWire** buses = nullptr, byte busCount = 0);
+};
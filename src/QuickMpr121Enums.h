@@ -246,3 +246,18 @@ enum mpr121Register : uint8_t {
   MPRREG_PWM_DUTY_2 = 0x83,
   MPRREG_PWM_DUTY_3 = 0x84,
 };
+
+/// bus traffic priority classes (see mpr121BusBudget)
+enum mpr121BusPriority : uint8_t {
+  MPR_PRIORITY_TOUCH = 0, ///< Touch/OOR status reads (never delayed)
+  MPR_PRIORITY_ANALOG = 1, ///< Filtered data and baseline reads
+  MPR_PRIORITY_LED = 2, ///< GPIO data and PWM writes (coalesced instead of delayed)
+  MPR_PRIORITY_DIAGNOSTIC = 3, ///< Everything else (configuration, charge settings, etc.)
+};
+
+/// what mpr121Discovery found at an address
+enum mpr121DeviceState : uint8_t {
+  MPR_DEVICE_IDENTIFIED = 0, ///< Registers had power-on values, so this is an MPR121
+  MPR_DEVICE_CONFIGURED = 1, ///< Responded, but has been configured since power-on so it couldn't be identified (probably an MPR121 that's already running)
+  MPR_DEVICE_UNKNOWN = 2, ///< Responded, but isn't an MPR121 (or reads failed)
+};
@@ -0,0 +1,129 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Bit-packed touch history and gestures.
+ * More info in QuickMpr121History.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121History.h"
+
+// Creates an empty history (all electrodes released).
+mpr121TouchHistory::mpr121TouchHistory()
+{
+  clear();
+}
+
+
+// Clears the history (all electrodes released).
+void mpr121TouchHistory::clear() {
+  for (byte i = 0; i < 13; i++) {
+    history[i] = 0;
+  }
+  current = 0;
+  previous = 0;
+}
+
+
+// Counts consecutive 1 bits starting at bit 0.
+byte mpr121TouchHistory::countTrailingOnes(uint32_t bits) {
+  bits = ~bits;
+  if (bits == 0)
+    return 32;
+  return __builtin_ctzl(bits);
+}
+
+
+// Adds a touch state (13 bits, as returned by mpr121::readTouchState()).
+void mpr121TouchHistory::update(short touchState) {
+  previous = current;
+  current = touchState & 0x1fff;
+
+  for (byte i = 0; i < 13; i++) {
+    history[i] = (history[i] << 1) | ((touchState >> i) & 1);
+  }
+}
+
+
+// Reads touch state from an mpr121 and adds it.
+// Returns the touch state.
+short mpr121TouchHistory::update(mpr121 &mpr) {
+  short touchState = mpr.readTouchState();
+  update(touchState);
+  return touchState;
+}
+
+
+// Gets how many updates an electrode has been touched for (0 if not touched, max 32).
+byte mpr121TouchHistory::getHeldSamples(byte electrode) {
+  if (electrode > 12)
+    return 0;
+
+  return countTrailingOnes(history[electrode]);
+}
+
+
+// Checks if an electrode has been touched for at least samples updates (max 32).
+bool mpr121TouchHistory::isHeld(byte electrode, byte samples) {
+  if (electrode > 12 || samples > 32)
+    return false;
+
+  uint32_t mask = samples < 32 ? ((uint32_t)1 << samples) - 1 : 0xffffffff;
+  return (history[electrode] & mask) == mask;
+}
+
+
+// Checks if an electrode was just released after being touched for at most maxSamples updates.
+bool mpr121TouchHistory::isTap(byte electrode, byte maxSamples) {
+  if (electrode > 12)
+    return false;
+
+  uint32_t bits = history[electrode];
+  if ((bits & 0b11) != 0b10) // released now, touched before
+    return false;
+
+  return countTrailingOnes(bits >> 1) <= maxSamples;
+}
+
+
+// Checks if an electrode was just released after two taps (each touched for at most maxSamples updates),
+// separated by at most maxGap released updates.
+bool mpr121TouchHistory::isDoubleTap(byte electrode, byte maxSamples, byte maxGap) {
+  if (!isTap(electrode, maxSamples))
+    return false;
+
+  // skip the release and second tap, leaving the gap in the low bits
+  byte secondTap = countTrailingOnes(history[electrode] >> 1);
+  if (secondTap > 29)
+    return false; // no room left for a gap and another tap
+  uint32_t bits = history[electrode] >> (1 + secondTap);
+
+  if (bits == 0)
+    return false; // no first tap
+  byte gap = __builtin_ctzl(bits);
+  if (gap > maxGap)
+    return false;
+
+  return countTrailingOnes(bits >> gap) <= maxSamples;
+}
+
+
+// Checks if all electrodes in mask were just completed as a chord:
+// they're all touched, the last of them was pressed at the last update, and each was pressed within the last window updates.
+bool mpr121TouchHistory::isChord(short mask, byte window, bool exclusive) {
+  mask &= 0x1fff;
+
+  if (mask == 0 || (current & mask) != mask || (getPressed() & mask) == 0)
+    return false;
+  if (exclusive && (current & ~mask) != 0)
+    return false;
+
+  for (byte i = 0; i < 13; i++) {
+    if (bitRead(mask, i) && countTrailingOnes(history[i]) > window)
+      return false;
+  }
+
+  return true;
+}
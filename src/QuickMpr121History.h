@@ -0,0 +1,112 @@
+/** \file QuickMpr121History.h
+ * bit-packed touch history and gestures for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+
+/**
+ * Keeps the last 32 touch states of each electrode as bits, so gestures can be checked without timers or events.
+ *
+ * Each electrode's history is a 32-bit shift register (bit 0 is the newest sample), shifted once per update().
+ * Gesture checks only look at bit runs in one register (using count trailing zeros), so they take the same time however long the gesture.
+ * Press/release edges and chords work on whole 13-bit state words, so all electrodes are checked at once.
+ *
+ * Times are counted in updates, so call update() at a steady rate (for example, once per ESI).
+ * Gesture checks are true for one update, just after the gesture completes.
+ */
+class mpr121TouchHistory {
+private:
+  uint32_t history[13]; ///< Touch history of ELE0-ELE11 and ELEPROX (bit 0 is the newest sample)
+  short current; ///< Touch state at the last update
+  short previous; ///< Touch state at the update before that
+
+  /**
+   * Counts consecutive 1 bits starting at bit 0.
+   */
+  static byte countTrailingOnes(uint32_t bits);
+
+public:
+  /**
+   * Creates an empty history (all electrodes released).
+   */
+  mpr121TouchHistory();
+
+  /**
+   * Clears the history (all electrodes released).
+   */
+  void clear();
+
+  /**
+   * Adds a touch state (13 bits, as returned by mpr121::readTouchState()).
+   */
+  void update(short touchState);
+
+  /**
+   * Reads touch state from an mpr121 and adds it.
+   * Returns the touch state.
+   */
+  short update(mpr121 &mpr);
+
+  /**
+   * Gets the raw history of one electrode (bit 0 is the newest sample, 1 is touched).
+   */
+  uint32_t getHistory(byte electrode) {
+    return electrode < 13 ? history[electrode] : 0;
+  }
+
+  /**
+   * Gets the touch state at the last update.
+   */
+  short getTouched() {
+    return current;
+  }
+
+  /**
+   * Gets electrodes that were pressed at the last update (touched now, not touched before).
+   */
+  short getPressed() {
+    return current & ~previous;
+  }
+
+  /**
+   * Gets electrodes that were released at the last update (not touched now, touched before).
+   */
+  short getReleased() {
+    return previous & ~current;
+  }
+
+  /**
+   * Gets how many updates an electrode has been touched for (0 if not touched, max 32).
+   */
+  byte getHeldSamples(byte electrode);
+
+  /**
+   * Checks if an electrode has been touched for at least samples updates (max 32).
+   */
+  bool isHeld(byte electrode, byte samples);
+
+  /**
+   * Checks if an electrode was just released after being touched for at most maxSamples updates.
+   */
+  bool isTap(byte electrode, byte maxSamples);
+
+  /**
+   * Checks if an electrode was just released after two taps (each touched for at most maxSamples updates),
+   * separated by at most maxGap released updates.
+   */
+  bool isDoubleTap(byte electrode, byte maxSamples, byte maxGap);
+
+  /**
+   * Checks if all electrodes in mask were just completed as a chord:
+   * they're all touched, the last of them was pressed at the last update, and each was pressed within the last window updates.
+   *
+   * \param mask       Electrodes in the chord (bit 0 is ELE0).
+   * \param window     Max updates between the first and last press.
+   * \param exclusive  If true, no other electrodes may be touched.
+   */
+  bool isChord(short mask, byte window, bool exclusive = false);
+};
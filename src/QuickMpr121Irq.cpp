@@ -0,0 +1,113 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Shared IRQ handling for multiple MPR121s.
+ * More info in QuickMpr121Irq.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Irq.h"
+
+// Creates a dispatcher for devices sharing one IRQ pin.
+// devices: Array of devices (must stay valid while the dispatcher is used).
+// count: Number of devices (max MPR121_IRQ_MAX_DEVICES).
+// irqPin: The MCU pin the IRQ line is connected to.
+mpr121IrqDispatcher::mpr121IrqDispatcher(mpr121** devices, byte count, byte irqPin)
+{
+  if (count > MPR121_IRQ_MAX_DEVICES)
+    count = MPR121_IRQ_MAX_DEVICES;
+
+  this->devices = devices;
+  this->count = count;
+  this->irqPin = irqPin;
+  enabledMask = (1 << count) - 1;
+  lastReadCount = 0;
+
+  for (byte i = 0; i < count; i++) {
+    order[i] = i;
+    score[i] = 0;
+    touchState[i] = 0;
+    changed[i] = 0;
+  }
+}
+
+
+// Sets up the IRQ pin, then reads every enabled device once to release the line and get initial touch states.
+void mpr121IrqDispatcher::begin() {
+  pinMode(irqPin, INPUT_PULLUP); // the MPR121 IRQ output is open drain
+
+  lastReadCount = 0;
+  for (byte i = 0; i < count; i++) {
+    if (bitRead(enabledMask, i))
+      readDevice(i);
+  }
+}
+
+
+// Sets whether a device can assert the IRQ line (devices only do so while running).
+void mpr121IrqDispatcher::setEnabled(byte device, bool enabled) {
+  if (device >= count)
+    return;
+
+  bitWrite(enabledMask, device, enabled);
+}
+
+
+// Reads one device's touch status (clearing its IRQ) and updates its state and score.
+// Returns true if the touch state changed.
+bool mpr121IrqDispatcher::readDevice(byte device) {
+  byte* rawdata = devices[device]->readRegister(MPRREG_ELE0_TO_ELE7_TOUCH_STATUS, 2);
+  short state = rawdata[0] | ((rawdata[1] & 0b00011111) << 8);
+
+  changed[device] = state ^ touchState[device];
+  touchState[device] = state;
+  lastReadCount++;
+
+  // a device that changed was almost certainly asserting, so it's likely to assert again soon
+  score[device] -= score[device] >> 2;
+  if (changed[device] != 0)
+    score[device] += 32;
+
+  return changed[device] != 0;
+}
+
+
+// If the IRQ line is asserted, reads devices in order of likelihood until it's released.
+// Each enabled device is read at most once.
+// Returns a mask of devices whose touch state changed (bit 0 is devices[0]).
+byte mpr121IrqDispatcher::service() {
+  lastReadCount = 0;
+  for (byte i = 0; i < count; i++) {
+    changed[i] = 0;
+  }
+
+  if (!isAsserted())
+    return 0;
+
+  byte changedMask = 0;
+  for (byte i = 0; i < count; i++) {
+    byte device = order[i];
+    if (!bitRead(enabledMask, device))
+      continue;
+
+    if (readDevice(device))
+      bitSet(changedMask, device);
+
+    if (!isAsserted())
+      break;
+  }
+
+  // keep devices sorted by score (insertion sort, stable so ties keep their order)
+  for (byte i = 1; i < count; i++) {
+    byte device = order[i];
+    byte j = i;
+    for ( ; j > 0 && score[order[j - 1]] < score[device]; j--) {
+      order[j] = order[j - 1];
+    }
+    order[j] = device;
+  }
+
+  return changedMask;
+}
@@ -0,0 +1,107 @@
+/** \file QuickMpr121Irq.h
+ * shared IRQ handling for multiple MPR121s
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+/// Max number of devices sharing one IRQ line
+#define MPR121_IRQ_MAX_DEVICES 8
+
+
+/**
+ * Services MPR121s whose IRQ outputs are wire-ORed to one pin.
+ *
+ * The IRQ line stays low until every asserting device has had its touch status read.
+ * Instead of reading every device when it's low, devices are read in order of how often they've recently had changes,
+ * and servicing stops as soon as the line goes high again.
+ * Devices that aren't enabled (for example, stopped devices) are never read.
+ *
+ * Touch state for each device is kept here, so the application doesn't need to read it again.
+ */
+class mpr121IrqDispatcher {
+private:
+  mpr121** devices; ///< Devices from constructor
+  byte count; ///< Number of devices from constructor
+  byte irqPin; ///< IRQ pin from constructor
+  byte enabledMask; ///< Devices that can assert the IRQ line (bit 0 is devices[0])
+  byte order[MPR121_IRQ_MAX_DEVICES]; ///< Device indices, most likely to be asserting first
+  byte score[MPR121_IRQ_MAX_DEVICES]; ///< Recent change rate of each device (decays by 1/4 each read)
+  short touchState[MPR121_IRQ_MAX_DEVICES]; ///< Last touch state of each device
+  short changed[MPR121_IRQ_MAX_DEVICES]; ///< Touch state bits that changed in the last service() of each device
+  byte lastReadCount; ///< Number of devices read in the last service()
+
+  /**
+   * Reads one device's touch status (clearing its IRQ) and updates its state and score.
+   * Returns true if the touch state changed.
+   */
+  bool readDevice(byte device);
+
+public:
+  /**
+   * Creates a dispatcher for devices sharing one IRQ pin.
+   * All devices are enabled initially.
+   *
+   * \param devices  Array of devices (must stay valid while the dispatcher is used).
+   * \param count    Number of devices (max MPR121_IRQ_MAX_DEVICES).
+   * \param irqPin   The MCU pin the IRQ line is connected to.
+   */
+  mpr121IrqDispatcher(mpr121** devices, byte count, byte irqPin);
+
+  /**
+   * Sets up the IRQ pin, then reads every enabled device once to release the line and get initial touch states.
+   * Call this after starting the devices.
+   */
+  void begin();
+
+  /**
+   * Sets whether a device can assert the IRQ line (devices only do so while running).
+   */
+  void setEnabled(byte device, bool enabled);
+
+  /**
+   * Checks if a device is enabled.
+   */
+  bool isEnabled(byte device) {
+    return device < count && bitRead(enabledMask, device);
+  }
+
+  /**
+   * Checks if the IRQ line is asserted.
+   */
+  bool isAsserted() {
+    return digitalRead(irqPin) == LOW;
+  }
+
+  /**
+   * If the IRQ line is asserted, reads devices in order of likelihood until it's released.
+   * Each enabled device is read at most once.
+   * Call this from loop() (or when an interrupt handler sets a flag -- I2C can't be used in the handler).
+   *
+   * Returns a mask of devices whose touch state changed (bit 0 is devices[0]).
+   */
+  byte service();
+
+  /**
+   * Gets the last touch state read from a device (13 bits, same as mpr121::readTouchState()).
+   */
+  short getTouchState(byte device) {
+    return device < count ? touchState[device] : 0;
+  }
+
+  /**
+   * Gets the touch state bits of a device that changed in the last service() (or begin()).
+   */
+  short getChanged(byte device) {
+    return device < count ? changed[device] : 0;
+  }
+
+  /**
+   * Gets the number of devices read in the last service().
+   */
+  byte getLastReadCount() {
+    return lastReadCount;
+  }
+};
@@ -0,0 +1,309 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Behavioural model of the analog front end.
+ * More info in QuickMpr121Model.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Model.h"
+#include <math.h>
+#include <string.h>
+
+
+// samples taken for each FFI and SFI setting
+static const uint8_t ffiSamples[4] = { 6, 10, 18, 34 };
+static const uint8_t sfiSamples[4] = { 4, 6, 10, 18 };
+
+
+// Sets all values to the same defaults as a newly created mpr121 (using the global CDC and CDT).
+void mpr121ModelConfig::setDefaults() {
+  touchThreshold = 0x0f;
+  releaseThreshold = 0x0a;
+
+  MHDrising = 0x01;
+  MHDfalling = 0x01;
+  NHDrising = 0x01;
+  NHDfalling = 0x03;
+  NHDtouched = 0x00;
+  NCLrising = 0x04;
+  NCLfalling = 0xc0;
+  NCLtouched = 0x00;
+  FDLrising = 0x00;
+  FDLfalling = 0x02;
+  FDLtouched = 0x00;
+
+  debounceTouch = 0x00;
+  debounceRelease = 0x00;
+
+  FFI = MPR_FFI_6;
+  CDC = 16;
+  CDT = MPR_CDT_0_5;
+  SFI = MPR_SFI_4;
+  ESI = MPR_ESI_1;
+}
+
+
+// Creates a model with default settings.
+mpr121AfeModel::mpr121AfeModel()
+{
+  vdd = 3.3f;
+  noiseCounts = 2;
+  electrodes = 12;
+  standbyMicroAmps = 3;
+  activeMicroAmps = 1000;
+  conversionMicros = 1;
+  seed = 121;
+  rngState = seed;
+}
+
+
+// Gets an approximately normally distributed random number (mean 0, standard deviation 1).
+float mpr121AfeModel::gaussian() {
+  // xorshift32, then the sum of its 4 bytes (close enough to normal, and much cheaper than Box-Muller)
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+
+  int sum = (rngState & 0xff) + ((rngState >> 8) & 0xff) + ((rngState >> 16) & 0xff) + (rngState >> 24);
+  return (sum - 510) * (1 / 147.8f); // 4 uniform bytes: mean 510, standard deviation sqrt(4 * (256^2 - 1) / 12)
+}
+
+
+// Gets the charge time (μs) for a CDT setting.
+float mpr121AfeModel::getChargeMicros(mpr121FilterCDT CDT) {
+  if (CDT == MPR_CDT_DISABLED)
+    return 0;
+  return 0.5f * (1 << (CDT - 1));
+}
+
+
+// Gets the ADC result (0-1023) for a capacitance (pF) without noise.
+float mpr121AfeModel::getADC(float capacitance, uint8_t CDC, mpr121FilterCDT CDT) {
+  // V = I * t / C, and μA * μs / pF is volts
+  float charge = CDC * getChargeMicros(CDT);
+  if (capacitance <= 0)
+    return charge > 0 ? 1023 : 0;
+
+  float adc = charge / capacitance / vdd * 1024;
+  return adc > 1023 ? 1023 : adc;
+}
+
+
+// Gets the capacitance (pF) that gives an ADC result (for turning recorded filtered data into a trace).
+float mpr121AfeModel::getCapacitance(float adc, uint8_t CDC, mpr121FilterCDT CDT) {
+  if (adc <= 0)
+    return 0;
+  return CDC * getChargeMicros(CDT) * 1024 / (adc * vdd);
+}
+
+
+// Estimates the average supply current (μA) of a configuration.
+float mpr121AfeModel::getMicroAmps(const mpr121ModelConfig &config) {
+  float chargeMicros = getChargeMicros(config.CDT);
+  float measurements = (float)electrodes * ffiSamples[config.FFI & 3];
+
+  // each measurement charges, discharges, and converts while drawing activeMicroAmps, plus the charge current itself
+  float perMeasurement = activeMicroAmps * (2 * chargeMicros + conversionMicros) + config.CDC * chargeMicros; // pC
+  return standbyMicroAmps + measurements * perMeasurement / (1000UL << config.ESI);
+}
+
+
+// Runs a configuration over a trace.
+mpr121ModelResult mpr121AfeModel::run(const mpr121ModelConfig &config, const mpr121ModelTrace &trace) {
+  mpr121ModelResult result;
+  memset(&result, 0, sizeof(result));
+  result.durationMicros = (uint64_t)trace.count * trace.intervalMicros;
+  result.averageMicroAmps = getMicroAmps(config);
+
+  if (trace.count == 0 || trace.intervalMicros == 0)
+    return result;
+
+  rngState = seed ? seed : 1;
+
+  uint32_t esiMicros = 1000UL << config.ESI;
+  uint8_t sfi = sfiSamples[config.SFI & 3];
+  float noise = noiseCounts / sqrtf(ffiSamples[config.FFI & 3]); // first filter averages independent samples
+  float adcScale = config.CDC * getChargeMicros(config.CDT) / vdd; // capacitance (pF) that charges to vdd, as in getADC()
+
+  // second filter
+  uint16_t sfiBuf[18];
+  uint32_t sfiSum = 0;
+  uint8_t sfiPos = 0;
+
+  // baseline filter
+  int baseline = 0;
+  int8_t noiseDir = 0;
+  uint8_t noiseCount = 0;
+  uint8_t fdlCount = 0;
+
+  // touch detection
+  bool touched = false;
+  uint8_t debounce = 0;
+
+  // ground truth
+  bool truthTouched = false;
+  bool matched = false; ///< the current real touch has been detected
+  bool releasePending = false; ///< a detected touch was really released, but detection hasn't released yet
+  uint64_t truthEdgeMicros = 0;
+  size_t truthIndex = 0;
+  uint64_t touchLatencySum = 0;
+  uint64_t releaseLatencySum = 0;
+  uint32_t releases = 0;
+
+  for (uint32_t step = 0; ; step++) {
+    uint64_t t = (uint64_t)step * esiMicros; // 32 bits would wrap after about 71 minutes and never reach the end of the trace
+    size_t index = t / trace.intervalMicros;
+    if (index >= trace.count)
+      break;
+
+    // ground truth edges up to this step (memchr finds the next one much faster than checking every step)
+    while (trace.touched && truthIndex <= index) {
+      const uint8_t* edge = (const uint8_t*)memchr(trace.touched + truthIndex, !truthTouched, index + 1 - truthIndex);
+      if (!edge) {
+        truthIndex = index + 1;
+        break;
+      }
+
+      truthIndex = edge - trace.touched;
+      truthTouched = !truthTouched;
+      truthEdgeMicros = (uint64_t)truthIndex * trace.intervalMicros;
+      if (truthTouched) {
+        result.touches++;
+        matched = false;
+        releasePending = false;
+      }
+      else {
+        if (!matched)
+          result.missed++;
+        releasePending = matched && touched;
+      }
+      truthIndex++;
+    }
+
+    // first filter: FFI measurements averaged
+    float capacitance = trace.capacitance[index];
+    float adc = (capacitance > adcScale ? adcScale / capacitance * 1024 : 1023) + gaussian() * noise;
+    uint16_t first = adc <= 0 ? 0 : (adc >= 1023 ? 1023 : (uint16_t)(adc + 0.5f));
+
+    // second filter: the last SFI first filter results averaged
+    if (step == 0) {
+      for (uint8_t i = 0; i < sfi; i++)
+        sfiBuf[i] = first;
+      sfiSum = (uint32_t)first * sfi;
+      baseline = first;
+    }
+    else {
+      sfiSum += first - sfiBuf[sfiPos];
+      sfiBuf[sfiPos] = first;
+      if (++sfiPos >= sfi)
+        sfiPos = 0;
+    }
+    int data = (sfiSum + sfi / 2) / sfi;
+
+    // thresholds and debounce (baseline registers only hold the upper 8 bits)
+    int delta = (baseline & ~3) - data;
+    if (!touched) {
+      if (delta > config.touchThreshold && ++debounce > config.debounceTouch) {
+        touched = true;
+        debounce = 0;
+
+        if (truthTouched && !matched) {
+          matched = true;
+          result.detected++;
+          uint32_t latency = (uint32_t)(t - truthEdgeMicros);
+          touchLatencySum += latency;
+          if (latency > result.maxTouchLatencyMicros)
+            result.maxTouchLatencyMicros = latency;
+        }
+        else {
+          result.falseTouches++;
+        }
+      }
+      else if (delta <= config.touchThreshold) {
+        debounce = 0;
+      }
+    }
+    else {
+      if (delta < config.releaseThreshold && ++debounce > config.debounceRelease) {
+        touched = false;
+        debounce = 0;
+
+        if (releasePending) {
+          releasePending = false;
+          releases++;
+          uint32_t latency = (uint32_t)(t - truthEdgeMicros);
+          releaseLatencySum += latency;
+          if (latency > result.maxReleaseLatencyMicros)
+            result.maxReleaseLatencyMicros = latency;
+        }
+      }
+      else if (delta >= config.releaseThreshold) {
+        debounce = 0;
+      }
+    }
+
+    // baseline filter
+    int diff = data - baseline;
+    int8_t dir = diff > 0 ? 1 : (diff < 0 ? -1 : 0);
+    uint8_t MHD, NHD, NCL, FDL;
+    if (touched) {
+      MHD = 0;
+      NHD = config.NHDtouched;
+      NCL = config.NCLtouched;
+      FDL = config.FDLtouched;
+    }
+    else if (dir > 0) {
+      MHD = config.MHDrising;
+      NHD = config.NHDrising;
+      NCL = config.NCLrising;
+      FDL = config.FDLrising;
+    }
+    else {
+      MHD = config.MHDfalling;
+      NHD = config.NHDfalling;
+      NCL = config.NCLfalling;
+      FDL = config.FDLfalling;
+    }
+
+    if (dir != noiseDir) {
+      noiseDir = dir;
+      noiseCount = 0;
+      fdlCount = 0;
+    }
+    if (dir == 0)
+      continue;
+
+    if (fdlCount < FDL) {
+      fdlCount++;
+      continue;
+    }
+    fdlCount = 0;
+
+    int magnitude = diff * dir;
+    if (!touched && magnitude <= 2 * MHD) {
+      baseline = data;
+      noiseCount = 0;
+    }
+    else if (noiseCount < NCL) {
+      noiseCount++;
+    }
+    else {
+      int change = 2 * NHD;
+      baseline += dir * (change < magnitude ? change : magnitude);
+      noiseCount = 0;
+    }
+  }
+
+  if (truthTouched && !matched)
+    result.missed++;
+
+  if (result.detected)
+    result.meanTouchLatencyMicros = touchLatencySum / result.detected;
+  if (releases)
+    result.meanReleaseLatencyMicros = releaseLatencySum / releases;
+
+  return result;
+}
@@ -0,0 +1,145 @@
+/** \file QuickMpr121Model.h
+ * behavioural model of the MPR121 analog front end, for predicting how configurations perform
+ *
+ * Intended for running on a host (see extras/ModelSweep), so this doesn't depend on Arduino.h.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "QuickMpr121Enums.h"
+
+
+/**
+ * Settings for one modelled electrode.
+ * Names match mpr121Config, so values can be copied across directly.
+ */
+struct mpr121ModelConfig {
+  uint8_t touchThreshold; ///< Touch detection threshold
+  uint8_t releaseThreshold; ///< Release detection threshold
+
+  uint8_t MHDrising; ///< "Max Half Delta" rising baseline adjustment value
+  uint8_t MHDfalling; ///< "Max Half Delta" falling baseline adjustment value
+  uint8_t NHDrising; ///< "Noise Half Delta" rising baseline adjustment value
+  uint8_t NHDfalling; ///< "Noise Half Delta" falling baseline adjustment value
+  uint8_t NHDtouched; ///< "Noise Half Delta" touched baseline adjustment value
+  uint8_t NCLrising; ///< "Noise Count Limit" rising baseline adjustment value
+  uint8_t NCLfalling; ///< "Noise Count Limit" falling baseline adjustment value
+  uint8_t NCLtouched; ///< "Noise Count Limit" touched baseline adjustment value
+  uint8_t FDLrising; ///< "Filter Delay Limit" rising baseline adjustment value
+  uint8_t FDLfalling; ///< "Filter Delay Limit" falling baseline adjustment value
+  uint8_t FDLtouched; ///< "Filter Delay Limit" touched baseline adjustment value
+
+  uint8_t debounceTouch; ///< "Debounce" count for touches -- max: 7
+  uint8_t debounceRelease; ///< "Debounce" count for releases -- max: 7
+
+  mpr121FilterFFI FFI; ///< "First Filter Iterations"
+  uint8_t CDC; ///< "Charge Discharge Current" (μA) -- max 63
+  mpr121FilterCDT CDT; ///< "Charge Discharge Time" (μs)
+  mpr121FilterSFI SFI; ///< "Second Filter Iterations"
+  mpr121FilterESI ESI; ///< "Electrode Sample Interval" (ms)
+
+  /**
+   * Sets all values to the same defaults as a newly created mpr121 (using the global CDC and CDT).
+   */
+  void setDefaults();
+};
+
+
+/**
+ * Capacitance of one electrode over time, optionally with when it was really touched.
+ */
+struct mpr121ModelTrace {
+  const float* capacitance; ///< Electrode capacitance (pF) for each step
+  const uint8_t* touched; ///< Whether the electrode was really touched at each step (1 if touched, 0 if not), or null if unknown
+  size_t count; ///< Number of steps
+  uint32_t intervalMicros; ///< Time between steps (μs) -- should be at most 1000 so the fastest ESI can be modelled
+};
+
+
+/**
+ * Predicted performance of a configuration over a trace.
+ *
+ * Touch counts and latencies need mpr121ModelTrace::touched.
+ */
+struct mpr121ModelResult {
+  uint32_t touches; ///< Touches in the trace
+  uint32_t detected; ///< Touches that were detected while still touched
+  uint32_t missed; ///< Touches that ended without being detected
+  uint32_t falseTouches; ///< Detections while not touched, plus repeat detections during one touch (chatter)
+  uint32_t meanTouchLatencyMicros; ///< Mean time from touch to detection
+  uint32_t maxTouchLatencyMicros; ///< Longest time from touch to detection
+  uint32_t meanReleaseLatencyMicros; ///< Mean time from release to detected release
+  uint32_t maxReleaseLatencyMicros; ///< Longest time from release to detected release
+  uint64_t durationMicros; ///< Length of the trace (64-bit, since long traces pass 2^32 μs)
+  float averageMicroAmps; ///< Estimated average supply current
+};
+
+
+/**
+ * Models what an MPR121 does with one electrode's capacitance, so configurations can be compared without flashing firmware.
+ *
+ * Every ESI, the model:
+ *  - measures capacitance FFI times by charging it with CDC for CDT, converting the voltage with a 10-bit ADC referenced to vdd
+ *    (with Gaussian noise of noiseCounts per sample), and averages the measurements (first filter)
+ *  - averages the last SFI first filter results to get filtered data (second filter, response time SFI * ESI)
+ *  - updates the baseline (AN3891): changes within 2 * MHD are tracked directly,
+ *    larger changes move it by 2 * NHD once they've lasted more than NCL samples, and the filter only runs every FDL + 1 samples
+ *  - compares baseline - filtered data with the thresholds, with debounce
+ *
+ * Auto-configuration and proximity detection aren't modelled, so pass in the CDC and CDT auto-configuration picked (see mpr121::readChargeConfig).
+ * Filtered data from a recording can be turned back into capacitance with getCapacitance() to replay real traces.
+ *
+ * The model is deterministic for a given seed, and a run only costs a few operations per ESI, so thousands of configurations can be swept in seconds.
+ * It's behavioural, not exact: expect trends and rankings to match hardware, not every sample.
+ */
+class mpr121AfeModel {
+private:
+  uint32_t rngState; ///< xorshift32 state for noise
+
+  /**
+   * Gets an approximately normally distributed random number (mean 0, standard deviation 1).
+   */
+  float gaussian();
+
+public:
+  /**
+   * Creates a model with default settings.
+   */
+  mpr121AfeModel();
+
+  float vdd; ///< Supply voltage, which is also the ADC reference (default 3.3)
+  float noiseCounts; ///< Standard deviation of measurement noise for one ADC sample (default 2, in counts)
+  uint8_t electrodes; ///< Number of electrodes being scanned, for power estimates (default 12)
+  float standbyMicroAmps; ///< Supply current between measurements (default 3)
+  float activeMicroAmps; ///< Supply current while measuring, not counting charge current (default 1000)
+  float conversionMicros; ///< Time taken by each ADC conversion, in addition to charge and discharge (default 1)
+  uint32_t seed; ///< Noise seed, so runs are repeatable (default 121)
+
+  /**
+   * Runs a configuration over a trace.
+   */
+  mpr121ModelResult run(const mpr121ModelConfig &config, const mpr121ModelTrace &trace);
+
+  /**
+   * Gets the ADC result (0-1023) for a capacitance (pF) without noise.
+   */
+  float getADC(float capacitance, uint8_t CDC, mpr121FilterCDT CDT);
+
+  /**
+   * Gets the capacitance (pF) that gives an ADC result (for turning recorded filtered data into a trace).
+   */
+  float getCapacitance(float adc, uint8_t CDC, mpr121FilterCDT CDT);
+
+  /**
+   * Estimates the average supply current (μA) of a configuration.
+   */
+  float getMicroAmps(const mpr121ModelConfig &config);
+
+  /**
+   * Gets the charge time (μs) for a CDT setting.
+   */
+  static float getChargeMicros(mpr121FilterCDT CDT);
+};
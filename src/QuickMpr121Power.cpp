@@ -0,0 +1,118 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Proximity-gated power management.
+ * More info in QuickMpr121Power.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Power.h"
+
+// Creates a power manager for an mpr121.
+// activeElectrodes: Number of electrodes to scan while active (the same as would be passed to mpr121::start()).
+mpr121PowerManager::mpr121PowerManager(mpr121 &mpr, byte activeElectrodes)
+{
+  if (activeElectrodes > 12)
+    activeElectrodes = 12;
+
+  this->mpr = &mpr;
+  this->activeElectrodes = activeElectrodes;
+  active = false;
+  lastActivityMillis = 0;
+  activeFilterConfig = 0;
+  idleFilterConfig = 0;
+  calLockBits = 0;
+
+  proxElectrodes = MPR_ELEPROX_0_TO_11;
+  idleESI = MPR_ESI_128;
+  activeTimeout = 5000;
+}
+
+
+// Switches between idle and active configurations.
+void mpr121PowerManager::applyMode(bool active) {
+  byte ELEPROX_EN_2 = proxElectrodes & 0b00000011;
+  byte ELE_EN_4 = active ? activeElectrodes : 0;
+
+  // filter config can only be changed in stop mode
+  // CL is kept, except that modes that load baselines are changed to plain tracking so baselines are kept when entering run mode
+  // mode switches are sent directly so the config image keeps the configured (active) values for apply()
+  mpr->sendWrite(MPRREG_ELECTRODE_CONFIG, &calLockBits, 1);
+
+  // filter config and electrode config are consecutive, so set both in one burst
+  byte regs[2] = {
+    active ? activeFilterConfig : idleFilterConfig,
+    (byte)(calLockBits | (ELEPROX_EN_2 << 4) | ELE_EN_4),
+  };
+  mpr->sendWrite(MPRREG_FILTER_CONFIG, regs, 2);
+
+  #if MPR121_FEATURE_ANALOG
+    mpr->samplePeriodMicros = 1000UL << (regs[0] & 0b00000111); // keep frame sample tracking in step with ESI
+  #endif
+
+  this->active = active;
+  lastActivityMillis = millis();
+}
+
+
+// Starts the mpr121 in active mode so all electrodes are auto-configured, then switches to idle.
+void mpr121PowerManager::begin() {
+  #if !MPR121_CONFIG_PROFILES
+    mpr->proxEnable = proxElectrodes;
+  #endif
+
+  mpr121Config config;
+  mpr->getConfig(config);
+
+  byte CDT_3 = (byte)config.globalCDT & 0b00000111;
+  byte SFI_2 = (byte)config.SFI & 0b00000011;
+  activeFilterConfig = (CDT_3 << 5) | (SFI_2 << 3) | ((byte)config.ESI & 0b00000111);
+  idleFilterConfig = (CDT_3 << 5) | (SFI_2 << 3) | ((byte)idleESI & 0b00000111);
+  calLockBits = mpr121::getRestartECR(((byte)config.calLock & 0b00000011) << 6);
+
+  mpr->start(activeElectrodes);
+
+  // wait for the first full sample (and auto-configuration) to complete
+  // response time is SFI samples * ESI ms
+  const byte sfiSamples[] = { 4, 6, 10, 18 };
+  delay(2 * sfiSamples[SFI_2] * (1 << (config.ESI & 0b111)));
+
+  // disable auto-configuration so mode switches don't recalibrate
+  // this is sent directly too, so a later start() or apply() still enables it as configured
+  mpr->sendWrite(MPRREG_ELECTRODE_CONFIG, &calLockBits, 1);
+  byte acc0 = mpr->readRegister(MPRREG_AUTOCONFIG_CONTROL_0) & 0b11111110;
+  mpr->sendWrite(MPRREG_AUTOCONFIG_CONTROL_0, &acc0, 1);
+
+  applyMode(false);
+}
+
+
+// Reads touch state and switches modes if needed.
+// Returns the 13 touch state bits (electrode bits are always 0 while idle).
+short mpr121PowerManager::update() {
+  byte* rawdata = mpr->readRegister(MPRREG_ELE0_TO_ELE7_TOUCH_STATUS, 2);
+  short touches = rawdata[0] | ((rawdata[1] & 0b00011111) << 8);
+
+  if (touches != 0) {
+    if (!active)
+      applyMode(true); // ELEPROX detected something
+    else
+      lastActivityMillis = millis();
+  }
+  else if (active && millis() - lastActivityMillis >= activeTimeout) {
+    applyMode(false);
+  }
+
+  return touches;
+}
+
+
+// Forces active mode (for example when the application expects input soon).
+void mpr121PowerManager::wake() {
+  if (!active)
+    applyMode(true);
+  else
+    lastActivityMillis = millis();
+}
@@ -0,0 +1,77 @@
+/** \file QuickMpr121Power.h
+ * proximity-gated power management for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+
+/**
+ * Idles an MPR121 in proximity-only mode and switches to full-speed touch sensing when something comes near.
+ *
+ * While idle, only ELEPROX is scanned with a long sample interval, which draws much less current.
+ * When ELEPROX detects something, all electrodes are scanned at the normal sample interval until nothing has been detected for activeTimeout ms.
+ *
+ * Transitions only rewrite the filter and electrode configuration registers, and keep baselines.
+ * Auto-configuration is disabled after begin(), so electrodes don't need to recalibrate when switching.
+ *
+ * These writes bypass the mpr121's config image, so mpr121::apply() still compares against the configured (active) values.
+ * If apply() has to restart the MPR121, it comes back in active mode with the new settings, so call begin() again afterwards.
+ */
+class mpr121PowerManager {
+private:
+  mpr121* mpr; ///< Device from constructor
+  byte activeElectrodes; ///< Number of electrodes to scan while active
+  bool active; ///< Whether the device is currently in active mode
+  unsigned long lastActivityMillis; ///< Last time a touch or proximity was detected while active
+  byte activeFilterConfig; ///< Filter config register value for active mode (set by begin)
+  byte idleFilterConfig; ///< Filter config register value for idle mode (set by begin)
+  byte calLockBits; ///< Calibration lock bits of the electrode config register (set by begin, modes that load baselines are changed to plain tracking)
+
+  /**
+   * Switches between idle and active configurations.
+   */
+  void applyMode(bool active);
+
+public:
+  /**
+   * Creates a power manager for an mpr121.
+   * Configure the mpr121's properties (thresholds, SFI, ESI, etc.) as usual before calling begin().
+   * If MPR121_CONFIG_PROFILES is true, the profile's proxEnable must match proxElectrodes.
+   *
+   * \param mpr               The device to manage.
+   * \param activeElectrodes  Number of electrodes to scan while active (the same as would be passed to mpr121::start()).
+   */
+  mpr121PowerManager(mpr121 &mpr, byte activeElectrodes = 12);
+
+  mpr121ElectrodeConfigProx proxElectrodes; ///< Electrodes combined for proximity detection (used in both modes, must not be MPR_ELEPROX_DISABLED)
+  mpr121FilterESI idleESI; ///< Sample interval while idle (the mpr121's ESI is used while active)
+  unsigned long activeTimeout; ///< Return to idle after nothing has been detected for this many ms
+
+  /**
+   * Starts the mpr121 in active mode so all electrodes are auto-configured, then switches to idle.
+   */
+  void begin();
+
+  /**
+   * Reads touch state and switches modes if needed.
+   * Call this regularly instead of mpr121::readTouchState().
+   *
+   * Returns the 13 touch state bits (electrode bits are always 0 while idle).
+   */
+  short update();
+
+  /**
+   * Checks if the device is in active (full scanning) mode.
+   */
+  bool isActive() {
+    return active;
+  }
+
+  /**
+   * Forces active mode (for example when the application expects input soon).
+   */
+  void wake();
+};
@@ -0,0 +1,192 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Background reader thread for Linux hosts.
+ * More info in QuickMpr121Reader.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Reader.h"
+
+#if MPR121_READER_THREAD
+
+#include <chrono>
+
+// Creates a reader for MPR121s that share one bus.
+// devices: Array of pointers to the devices to read.
+// count: Number of devices (max 4).
+// intervalMicros: Minimum time between reads of all devices (0 reads as fast as possible).
+mpr121Reader::mpr121Reader(mpr121** devices, byte count, unsigned long intervalMicros)
+  : running(false), intervalMicros(intervalMicros)
+{
+  if (count > 4)
+    count = 4;
+
+  deviceCount = count;
+  for (byte i = 0; i < count; i++) {
+    this->devices[i] = devices[i];
+  }
+
+  for (byte i = 0; i < 4; i++) {
+    slots[i].seq = 0;
+  }
+}
+
+// Stops the reader thread if it's running.
+mpr121Reader::~mpr121Reader() {
+  end();
+}
+
+
+// Starts the reader thread.
+// Returns false if it was already running.
+bool mpr121Reader::begin() {
+  if (running.exchange(true))
+    return false;
+
+  thread = std::thread(&mpr121Reader::run, this);
+  return true;
+}
+
+// Stops the reader thread and waits for it to finish.
+// Queued commands are applied before stopping.
+void mpr121Reader::end() {
+  running = false;
+  if (thread.joinable())
+    thread.join();
+}
+
+
+// Main loop for the reader thread.
+void mpr121Reader::run() {
+  mpr121Frame frame;
+  auto nextRead = std::chrono::steady_clock::now();
+
+  while (running) {
+    applyCommands();
+
+    for (byte i = 0; i < deviceCount; i++) {
+      devices[i]->readFrame(frame);
+      publish(i, frame);
+    }
+
+    nextRead += std::chrono::microseconds(intervalMicros.load());
+    auto now = std::chrono::steady_clock::now();
+    if (nextRead > now)
+      std::this_thread::sleep_until(nextRead);
+    else
+      nextRead = now; // running behind, don't try to catch up with a burst of reads
+  }
+
+  applyCommands();
+}
+
+// Applies all queued commands.
+// Consecutive register writes to the same device are combined into burst writes.
+void mpr121Reader::applyCommands() {
+  std::vector<command> commands;
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    commands.swap(commandQueue);
+  }
+
+  byte burst[MPR121_I2C_BUFLEN - 1];
+  byte burstLen = 0;
+  byte burstDevice = 0;
+  mpr121Register burstStart = MPRREG_ELE0_TO_ELE7_TOUCH_STATUS;
+
+  for (size_t i = 0; i <= commands.size(); i++) {
+    command* cmd = i < commands.size() ? &commands[i] : nullptr;
+
+    // flush the current burst if this command can't be added to it
+    bool continuesBurst = cmd && !cmd->func && burstLen > 0 && burstLen < sizeof(burst) &&
+                          cmd->device == burstDevice && cmd->reg == burstStart + burstLen;
+    if (burstLen > 0 && !continuesBurst) {
+      if (burstLen == 1)
+        devices[burstDevice]->writeRegister(burstStart, burst[0]);
+      else
+        devices[burstDevice]->writeRegister(burstStart, burst, burstLen);
+      burstLen = 0;
+    }
+
+    if (!cmd || cmd->device >= deviceCount)
+      continue;
+
+    if (cmd->func) {
+      cmd->func(*devices[cmd->device]);
+    }
+    else {
+      if (burstLen == 0) {
+        burstDevice = cmd->device;
+        burstStart = cmd->reg;
+      }
+      burst[burstLen++] = cmd->value;
+    }
+  }
+}
+
+// Publishes a frame for a device.
+// Only call this from the reader thread.
+void mpr121Reader::publish(byte device, const mpr121Frame &frame) {
+  frameSlot &slot = slots[device];
+  unsigned long seq = slot.seq.load(std::memory_order_relaxed);
+
+  slot.seq.store(seq + 1, std::memory_order_relaxed); // odd: write in progress
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.frame = frame;
+  slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+
+// Copies the latest frame for a device.
+// This is lock-free and safe to call from any thread.
+// Returns false if no frame has been read yet (frame won't be modified).
+bool mpr121Reader::readLatest(byte device, mpr121Frame &frame) const {
+  if (device >= deviceCount)
+    return false;
+
+  const frameSlot &slot = slots[device];
+  mpr121Frame copy;
+  unsigned long seqBefore, seqAfter;
+
+  do {
+    seqBefore = slot.seq.load(std::memory_order_acquire);
+    if (seqBefore == 0)
+      return false;
+    if (seqBefore & 1)
+      continue; // write in progress, try again
+
+    copy = slot.frame;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    seqAfter = slot.seq.load(std::memory_order_relaxed);
+  } while ((seqBefore & 1) || seqBefore != seqAfter);
+
+  frame = copy;
+  return true;
+}
+
+// Gets the number of frames published for a device.
+unsigned long mpr121Reader::frameCount(byte device) const {
+  if (device >= deviceCount)
+    return 0;
+
+  return slots[device].seq.load(std::memory_order_acquire) / 2;
+}
+
+
+// Queues a register write for a device.
+// Writes are applied between reads, in order, and consecutive registers are sent in burst writes.
+void mpr121Reader::queueWrite(byte device, mpr121Register reg, byte value) {
+  std::lock_guard<std::mutex> lock(queueMutex);
+  commandQueue.push_back({device, reg, value, nullptr});
+}
+
+// Queues a command to run on the reader thread between reads.
+void mpr121Reader::queueCommand(byte device, std::function<void(mpr121&)> func) {
+  std::lock_guard<std::mutex> lock(queueMutex);
+  commandQueue.push_back({device, MPRREG_ELE0_TO_ELE7_TOUCH_STATUS, 0, func});
+}
+
+#endif // MPR121_READER_THREAD
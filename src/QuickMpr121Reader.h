@@ -0,0 +1,134 @@
+/** \file QuickMpr121Reader.h
+ * background reader thread for QuickMpr121 (Linux only)
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+#if MPR121_READER_THREAD
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Background reader for all MPR121s on one I2C bus.
+ *
+ * While running, the reader thread owns all I2C traffic for its devices -- don't call mpr121 functions directly
+ * (use queueWrite or queueCommand instead).
+ * The latest frame for each device is published with a seqlock, so any number of threads can read consistent snapshots without locking.
+ */
+class mpr121Reader {
+private:
+  /// Seqlock-protected frame storage for one device
+  struct frameSlot {
+    std::atomic<unsigned long> seq; ///< Odd while a write is in progress, zero if no frame has been published yet
+    mpr121Frame frame; ///< Latest published frame
+  };
+
+  /// Queued register write or command
+  struct command {
+    byte device; ///< Index of the device to apply this to
+    mpr121Register reg; ///< Register to write (if func is empty)
+    byte value; ///< Value to write (if func is empty)
+    std::function<void(mpr121&)> func; ///< Command to run (if not empty)
+  };
+
+  mpr121* devices[4]; ///< Devices from constructor
+  byte deviceCount; ///< Number of devices from constructor
+  frameSlot slots[4]; ///< Published frames for each device
+
+  std::thread thread; ///< The reader thread
+  std::atomic<bool> running; ///< Whether the reader thread should keep running
+  std::atomic<unsigned long> intervalMicros; ///< Minimum time between reads of all devices
+
+  std::mutex queueMutex; ///< Protects commandQueue
+  std::vector<command> commandQueue; ///< Commands waiting to be applied by the reader thread
+
+  /**
+   * Main loop for the reader thread.
+   */
+  void run();
+
+  /**
+   * Applies all queued commands.
+   * Consecutive register writes to the same device are combined into burst writes.
+   */
+  void applyCommands();
+
+  /**
+   * Publishes a frame for a device.
+   * Only call this from the reader thread.
+   */
+  void publish(byte device, const mpr121Frame &frame);
+
+public:
+  /**
+   * Creates a reader for MPR121s that share one bus.
+   *
+   * \param devices         Array of pointers to the devices to read (they should already be started, or use queueCommand to start them).
+   * \param count           Number of devices (max 4, because that's all that fit on one bus).
+   * \param intervalMicros  Minimum time between reads of all devices (0 reads as fast as possible).
+   */
+  mpr121Reader(mpr121** devices, byte count, unsigned long intervalMicros = 1000);
+
+  /**
+   * Stops the reader thread if it's running.
+   */
+  ~mpr121Reader();
+
+  mpr121Reader(const mpr121Reader&) = delete;
+  mpr121Reader& operator=(const mpr121Reader&) = delete;
+
+  /**
+   * Starts the reader thread.
+   * Returns false if it was already running.
+   */
+  bool begin();
+
+  /**
+   * Stops the reader thread and waits for it to finish.
+   * Queued commands are applied before stopping.
+   */
+  void end();
+
+  /**
+   * Sets the minimum time between reads of all devices.
+   */
+  void setInterval(unsigned long micros) {
+    intervalMicros = micros;
+  }
+
+  /**
+   * Copies the latest frame for a device.
+   * This is lock-free and safe to call from any thread.
+   *
+   * Returns false if no frame has been read yet (frame won't be modified).
+   */
+  bool readLatest(byte device, mpr121Frame &frame) const;
+
+  /**
+   * Gets the number of frames published for a device.
+   * This can be used to check whether a new frame is available since the last readLatest.
+   */
+  unsigned long frameCount(byte device) const;
+
+  /**
+   * Queues a register write for a device.
+   * Writes are applied between reads, in order, and consecutive registers are sent in burst writes.
+   */
+  void queueWrite(byte device, mpr121Register reg, byte value);
+
+  /**
+   * Queues a command to run on the reader thread between reads.
+   * Use this for things like `start()` or GPIO functions: `reader.queueCommand(0, [](mpr121 &mpr) { mpr.start(12); });`
+   */
+  void queueCommand(byte device, std::function<void(mpr121&)> func);
+};
+
+#endif // MPR121_READER_THREAD
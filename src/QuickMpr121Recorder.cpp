@@ -0,0 +1,202 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Recording and replay of raw register frames.
+ * More info in QuickMpr121Recorder.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Recorder.h"
+
+#if MPR121_FEATURE_ANALOG
+
+#if MPR121_REPLAY
+  #include <chrono>
+  #include <thread>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+
+// Writes the recording header, including the current configuration of each device.
+// Call this once after starting all devices and before recording any frames.
+void mpr121Recorder::begin(mpr121** devices, byte count) {
+  mpr121RecordHeader header;
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, MPR121_RECORD_MAGIC, sizeof(header.magic));
+  header.version = MPR121_RECORD_VERSION;
+  header.headerSize = sizeof(mpr121RecordHeader);
+  header.recordSize = sizeof(mpr121Record);
+
+  for (byte i = 0; i < count && i < 4; i++) {
+    byte addr = devices[i]->i2cAddr;
+    if (addr < 0x5a || addr > 0x5d)
+      continue;
+
+    bitSet(header.deviceMask, addr - 0x5a);
+    devices[i]->readRegisters(MPRREG_MHD_RISING, MPR121_RAW_CONFIG_LEN, header.config[addr - 0x5a]);
+  }
+
+  out->write((const uint8_t*)&header, sizeof(header));
+}
+
+// Reads a frame from a device and writes it to the recording.
+// frame: Optionally also decode the frame into this.
+void mpr121Recorder::record(mpr121 &mpr, mpr121Frame* frame) {
+  mpr121Record rec;
+
+  rec.micros = micros();
+  rec.i2cAddr = mpr.i2cAddr;
+  mpr.readRawFrame(rec.regs);
+
+  out->write((const uint8_t*)&rec, sizeof(rec));
+
+  unsigned long sample = mpr.trackSample(rec.regs, rec.micros);
+
+  if (frame) {
+    frame->micros = rec.micros;
+    frame->sample = sample;
+    mpr121::decodeFrame(rec.regs, *frame);
+  }
+}
+
+
+#if MPR121_REPLAY
+
+mpr121ReplayFile::~mpr121ReplayFile() {
+  close();
+}
+
+// Opens and maps a recording.
+// Returns false if the file can't be opened or isn't a valid recording.
+bool mpr121ReplayFile::open(const char* path) {
+  close();
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(mpr121RecordHeader)) {
+    ::close(fd);
+    return false;
+  }
+
+  void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd); // the mapping stays valid
+  if (mapped == MAP_FAILED)
+    return false;
+
+  data = (const byte*)mapped;
+  length = st.st_size;
+
+  const mpr121RecordHeader* hdr = header();
+  if (memcmp(hdr->magic, MPR121_RECORD_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != MPR121_RECORD_VERSION ||
+      hdr->headerSize != sizeof(mpr121RecordHeader) || hdr->recordSize != sizeof(mpr121Record)) {
+    close();
+    return false;
+  }
+
+  count = (length - sizeof(mpr121RecordHeader)) / sizeof(mpr121Record); // ignore a partly written final record
+  madvise((void*)data, length, MADV_SEQUENTIAL);
+  return true;
+}
+
+// Unmaps the recording.
+void mpr121ReplayFile::close() {
+  if (data)
+    munmap((void*)data, length);
+
+  data = nullptr;
+  length = 0;
+  count = 0;
+}
+
+
+// Creates a transport for a recording.
+// realtime: If true, next() waits to match the recorded timing. If false, replay runs as fast as possible.
+mpr121ReplayTransport::mpr121ReplayTransport(const mpr121ReplayFile &file, bool realtime)
+  : file(&file), realtime(realtime), position(0), firstMicros(0), startNanos(0)
+{
+  memset(regs, 0, sizeof(regs));
+
+  const mpr121RecordHeader* hdr = file.header();
+  if (!hdr)
+    return; // file isn't open, so registers stay zeroed (and there are no records to replay)
+
+  for (byte i = 0; i < 4; i++) {
+    memcpy(&regs[i][MPRREG_MHD_RISING], hdr->config[i], MPR121_RAW_CONFIG_LEN);
+  }
+}
+
+// Moves to a record without waiting.
+// Registers for other devices keep their previous values.
+void mpr121ReplayTransport::seek(size_t index) {
+  position = index;
+  startNanos = 0; // restart realtime pacing from here
+}
+
+// Applies the next record.
+// Returns the I2C address of the device it was recorded from, or 0 when there are no more records.
+byte mpr121ReplayTransport::next() {
+  if (position >= file->recordCount())
+    return 0;
+
+  const mpr121Record* rec = file->record(position++);
+
+  if (realtime) {
+    unsigned long long nowNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    if (startNanos == 0) {
+      startNanos = nowNanos;
+      firstMicros = rec->micros;
+    }
+    else {
+      unsigned long long targetNanos = startNanos + (unsigned long long)(uint32_t)(rec->micros - firstMicros) * 1000; // unsigned subtraction handles micros() overflow
+      if (targetNanos > nowNanos)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(targetNanos - nowNanos));
+    }
+  }
+
+  if (rec->i2cAddr >= 0x5a && rec->i2cAddr <= 0x5d)
+    memcpy(regs[rec->i2cAddr - 0x5a], rec->regs, MPR121_RAW_FRAME_LEN);
+
+  return rec->i2cAddr;
+}
+
+// Gets the micros() timestamp of the last applied record.
+uint32_t mpr121ReplayTransport::currentMicros() const {
+  if (position == 0)
+    return 0;
+
+  return file->record(position - 1)->micros;
+}
+
+void mpr121ReplayTransport::write(byte i2cAddr, mpr121Register addr, const byte* values, byte count) {
+  if (i2cAddr < 0x5a || i2cAddr > 0x5d)
+    return;
+
+  for (byte i = 0; i < count && addr + i < (int)sizeof(regs[0]); i++) {
+    regs[i2cAddr - 0x5a][addr + i] = values[i];
+  }
+}
+
+byte mpr121ReplayTransport::read(byte i2cAddr, mpr121Register addr, byte* dest, byte count) {
+  if (i2cAddr < 0x5a || i2cAddr > 0x5d)
+    return 0;
+
+  byte i = 0;
+  for ( ; i < count && addr + i < (int)sizeof(regs[0]); i++) {
+    dest[i] = regs[i2cAddr - 0x5a][addr + i];
+  }
+  return i;
+}
+
+#endif // MPR121_REPLAY
+
+#endif // MPR121_FEATURE_ANALOG
@@ -0,0 +1,206 @@
+/** \file QuickMpr121Recorder.h
+ * recording and replay of raw register frames for QuickMpr121
+ *
+ * Recordings are a mpr121RecordHeader followed by any number of fixed-size mpr121Records.
+ * All values are little-endian.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+#if MPR121_FEATURE_ANALOG
+
+#if MPR121_REPLAY
+  #include <stdio.h>
+#endif
+
+/// Magic bytes at the start of a recording
+#define MPR121_RECORD_MAGIC "M121"
+
+/// Version of the recording format
+#define MPR121_RECORD_VERSION 1
+
+
+/**
+ * Header at the start of a recording.
+ * Holds the configuration registers for each recorded device, as set by mpr121::start().
+ */
+struct mpr121RecordHeader {
+  char magic[4]; ///< Always MPR121_RECORD_MAGIC
+  uint16_t version; ///< MPR121_RECORD_VERSION
+  uint16_t headerSize; ///< sizeof(mpr121RecordHeader)
+  uint16_t recordSize; ///< sizeof(mpr121Record)
+  uint8_t deviceMask; ///< Bit n is set if the device at address 0x5a+n was recorded
+  uint8_t reserved[5]; ///< Unused, always 0
+  uint8_t config[4][MPR121_RAW_CONFIG_LEN]; ///< Registers 0x2B-0x7F for each device (indexed by address - 0x5a)
+};
+
+/**
+ * A single recorded frame.
+ */
+struct mpr121Record {
+  uint32_t micros; ///< Host micros() timestamp taken just before reading
+  uint8_t i2cAddr; ///< I2C address of the device this was read from
+  uint8_t regs[MPR121_RAW_FRAME_LEN]; ///< Raw registers 0x00-0x2A
+};
+
+static_assert(sizeof(mpr121RecordHeader) == 356, "mpr121RecordHeader has unexpected padding");
+static_assert(sizeof(mpr121Record) == 48, "mpr121Record has unexpected padding");
+
+
+/**
+ * Writes recordings of raw register frames.
+ *
+ * Output can go to anything that implements Print (for example an SD library File).
+ */
+class mpr121Recorder {
+private:
+  Print* out; ///< Print from constructor
+
+public:
+  /**
+   * Creates a recorder that writes to out.
+   */
+  mpr121Recorder(Print &out) : out(&out) {}
+
+  /**
+   * Writes the recording header, including the current configuration of each device.
+   * Call this once after starting all devices and before recording any frames.
+   *
+   * \param devices  Array of pointers to the devices that will be recorded.
+   * \param count    Number of devices (max 4).
+   */
+  void begin(mpr121** devices, byte count);
+
+  /**
+   * Reads a frame from a device and writes it to the recording.
+   *
+   * \param mpr    The device to read.
+   * \param frame  Optionally also decode the frame into this.
+   */
+  void record(mpr121 &mpr, mpr121Frame* frame = nullptr);
+};
+
+
+#if MPR121_REPLAY
+
+/**
+ * Read-only access to a recording using mmap, so large recordings don't need to be loaded into RAM.
+ */
+class mpr121ReplayFile {
+private:
+  const byte* data; ///< Mapped file contents
+  size_t length; ///< Length of the mapping
+  size_t count; ///< Number of complete records
+
+public:
+  mpr121ReplayFile() : data(nullptr), length(0), count(0) {}
+  ~mpr121ReplayFile();
+
+  mpr121ReplayFile(const mpr121ReplayFile&) = delete;
+  mpr121ReplayFile& operator=(const mpr121ReplayFile&) = delete;
+
+  /**
+   * Opens and maps a recording.
+   * Returns false if the file can't be opened or isn't a valid recording.
+   */
+  bool open(const char* path);
+
+  /**
+   * Unmaps the recording.
+   */
+  void close();
+
+  /**
+   * Gets the recording header.
+   */
+  const mpr121RecordHeader* header() const {
+    return (const mpr121RecordHeader*)data;
+  }
+
+  /**
+   * Gets the number of records.
+   */
+  size_t recordCount() const {
+    return count;
+  }
+
+  /**
+   * Gets a record. This doesn't copy any data.
+   */
+  const mpr121Record* record(size_t index) const {
+    return (const mpr121Record*)(data + sizeof(mpr121RecordHeader) + index * sizeof(mpr121Record));
+  }
+};
+
+
+/**
+ * Transport that feeds a recording back to mpr121 instances (see mpr121::setTransport).
+ *
+ * Reads of 0x00-0x2A return the current record for each device, and other registers return the recorded configuration.
+ * Writes only modify the replayed register values.
+ */
+class mpr121ReplayTransport : public mpr121Transport {
+private:
+  const mpr121ReplayFile* file; ///< File from constructor
+  bool realtime; ///< Whether next() should wait to match recorded timing
+  size_t position; ///< Index of the next record to replay
+  byte regs[4][MPRREG_PWM_DUTY_3 + 1]; ///< Current register values for each device
+  uint32_t firstMicros; ///< Timestamp of the first replayed record
+  unsigned long long startNanos; ///< Host time when the first record was replayed
+
+public:
+  /**
+   * Creates a transport for a recording.
+   *
+   * \param file      The recording to replay (must stay open while replaying). If it isn't open, all registers read as 0.
+   * \param realtime  If true, next() waits to match the recorded timing. If false, replay runs as fast as possible.
+   */
+  mpr121ReplayTransport(const mpr121ReplayFile &file, bool realtime = false);
+
+  /**
+   * Moves to a record without waiting.
+   * Registers for other devices keep their previous values.
+   */
+  void seek(size_t index);
+
+  /**
+   * Applies the next record.
+   * Returns the I2C address of the device it was recorded from, or 0 when there are no more records.
+   */
+  byte next();
+
+  /**
+   * Gets the micros() timestamp of the last applied record.
+   */
+  uint32_t currentMicros() const;
+
+  void write(byte i2cAddr, mpr121Register addr, const byte* values, byte count) override;
+  byte read(byte i2cAddr, mpr121Register addr, byte* dest, byte count) override;
+};
+
+
+/**
+ * Print that writes to a stdio FILE, for recording on Linux hosts.
+ */
+class mpr121FilePrint : public Print {
+private:
+  FILE* file; ///< FILE from constructor
+
+public:
+  mpr121FilePrint(FILE* file) : file(file) {}
+
+  size_t write(uint8_t value) override {
+    return fwrite(&value, 1, 1, file);
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) override {
+    return fwrite(buffer, 1, size, file);
+  }
+};
+
+#endif // MPR121_REPLAY
+
+#endif // MPR121_FEATURE_ANALOG
@@ -0,0 +1,136 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Reset/brown-out detection and recovery.
+ * More info in QuickMpr121Reset.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Reset.h"
+
+#if MPR121_FEATURE_APPLY
+
+// Creates a reset monitor for an mpr121.
+mpr121ResetMonitor::mpr121ResetMonitor(mpr121 &mpr)
+{
+  this->mpr = &mpr;
+  updateCount = 0;
+  checkCount = 0;
+  haveSnapshot = false;
+  resetCount = 0;
+  lastRecoveryMicros = 0;
+
+  checkInterval = 32;
+  snapshotInterval = 16;
+}
+
+
+// Saves charge settings and baselines.
+void mpr121ResetMonitor::takeSnapshot() {
+  mpr->readRegisters(MPRREG_ELE0_CDC, MPR121_RAW_CHARGE_LEN, chargeSnapshot);
+  mpr->readRegisters(MPRREG_ELE0_BASELINE, 13, baselineSnapshot);
+  haveSnapshot = true;
+  checkCount = 0;
+}
+
+
+// Saves charge settings and baselines.
+// Call this after start() once auto-configuration has finished (a few hundred ms is plenty).
+void mpr121ResetMonitor::begin() {
+  takeSnapshot();
+  updateCount = 0;
+}
+
+
+// Reads touch state, and checks for a reset every checkInterval calls.
+// Returns the 13 touch state bits (0 if the device was just recovered).
+short mpr121ResetMonitor::update() {
+  short touchState = mpr->readTouchState();
+
+  if (checkInterval && ++updateCount >= checkInterval && check())
+    return 0;
+
+  return touchState;
+}
+
+
+// Checks for a reset now, and recovers if there was one.
+// Returns true if a reset was detected.
+bool mpr121ResetMonitor::check() {
+  updateCount = 0;
+
+  if (!mpr->configImageValid)
+    return false; // not started, so nothing to compare against
+
+  // AFE config, filter config, and electrode config are consecutive, and almost never all at power-on values after start()
+  const byte* expected = &mpr->configImage[MPRREG_AFE_CONFIG - MPRREG_MHD_RISING];
+  byte* rawdata = mpr->readRegister(MPRREG_AFE_CONFIG, 3);
+
+  bool powerOn = rawdata[0] == 0x10 && rawdata[1] == 0x24 && rawdata[2] == 0x00;
+  if (powerOn && memcmp(rawdata, expected, 3) != 0) {
+    resetCount++;
+    recover();
+    return true;
+  }
+
+  if (snapshotInterval && ++checkCount >= snapshotInterval && (expected[2] & 0b00111111) != 0)
+    takeSnapshot();
+
+  return false;
+}
+
+
+// Writes the register image, charge settings, and baselines back (whether there was a reset or not).
+void mpr121ResetMonitor::recover() {
+  unsigned long startMicros = micros();
+  const byte* image = mpr->configImage;
+  byte ecr = image[MPRREG_ELECTRODE_CONFIG - MPRREG_MHD_RISING];
+
+  // stop first, in case there wasn't a reset (config registers can't be written while running)
+  // this is sent directly so the image keeps the configured value
+  byte stopECR = ecr & 0b11000000;
+  mpr->sendWrite(MPRREG_ELECTRODE_CONFIG, &stopECR, 1);
+
+  // baseline filters, thresholds, debounce, AFE config, and filter config (0x2B-0x5D)
+  mpr->writeRegisters(MPRREG_MHD_RISING, image, MPRREG_ELECTRODE_CONFIG - MPRREG_MHD_RISING);
+
+  // per-electrode charge settings and GPIO config (0x5F-0x77, skipping set/clear/toggle)
+  byte rawdata[MPRREG_GPIO_DATA_SET - MPRREG_ELE0_CDC];
+  memcpy(rawdata, &image[MPRREG_ELE0_CDC - MPRREG_MHD_RISING], sizeof(rawdata));
+  if (haveSnapshot)
+    memcpy(rawdata, chargeSnapshot, MPR121_RAW_CHARGE_LEN);
+  mpr->writeRegisters(MPRREG_ELE0_CDC, rawdata, sizeof(rawdata));
+
+  // auto-configuration (0x7B-0x7F)
+  memcpy(rawdata, &image[MPRREG_AUTOCONFIG_CONTROL_0 - MPRREG_MHD_RISING], 5);
+  if (haveSnapshot) {
+    // charge settings were restored, so starting doesn't need to run auto-configuration (ACE)
+    // this is sent directly so the image keeps the configured value for later start() and apply() calls
+    rawdata[0] &= ~0b1;
+    mpr->sendWrite(MPRREG_AUTOCONFIG_CONTROL_0, rawdata, 5);
+  }
+  else
+    mpr->writeRegisters(MPRREG_AUTOCONFIG_CONTROL_0, rawdata, 5);
+
+  // baselines can only be written while stopped
+  if (haveSnapshot)
+    mpr->writeRegisters(MPRREG_ELE0_BASELINE, baselineSnapshot, 13);
+
+  // electrode config goes last, so it starts with everything else already set
+  // with restored baselines, calibration lock modes that load new ones start as plain tracking instead (the image keeps the configured value)
+  byte startECR = haveSnapshot ? mpr121::getRestartECR(ecr) : ecr;
+  mpr->sendWrite(MPRREG_ELECTRODE_CONFIG, &startECR, 1);
+
+  #if MPR121_FEATURE_BUDGET && MPR121_FEATURE_GPIO
+    mpr->ledPWMKnown = 0; // PWM registers were reset
+  #endif
+  #if MPR121_FEATURE_ANALOG
+    mpr->sampleTracking = false; // sampling restarted
+  #endif
+
+  lastRecoveryMicros = micros() - startMicros;
+}
+
+#endif // MPR121_FEATURE_APPLY
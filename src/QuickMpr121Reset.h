@@ -0,0 +1,93 @@
+/** \file QuickMpr121Reset.h
+ * reset/brown-out detection and recovery for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+#if MPR121_FEATURE_APPLY
+
+/**
+ * Notices when an MPR121 has been reset behind the library's back (brown-out, ESD, etc.) and puts it back how it was.
+ *
+ * A reset MPR121 comes back stopped with power-on register values, so touches just stop working.
+ * Every checkInterval updates, the monitor reads AFE config, filter config, and electrode config (one 3 byte read)
+ * and compares them against what was last written (the mpr121's apply() register image).
+ * A reset is detected when they differ and match power-on values, so failed reads aren't mistaken for resets.
+ *
+ * Recovery writes the register image back in a few bursts and restarts with the same electrodes.
+ * Per-electrode charge settings and baselines from the last snapshot are restored too, so auto-configuration doesn't have to run again
+ * and touches work within a couple of sample intervals.
+ * PWM duty cycles aren't restored.
+ *
+ * A reset while stopped with default AFE and filter config can't be detected (but there's also nothing running to lose).
+ */
+class mpr121ResetMonitor {
+private:
+  mpr121* mpr; ///< Device from constructor
+  byte updateCount; ///< Updates since the last check
+  byte checkCount; ///< Checks since the last snapshot
+  bool haveSnapshot; ///< Whether charge and baselines have been saved
+  byte chargeSnapshot[MPR121_RAW_CHARGE_LEN]; ///< Per-electrode CDC and CDT registers from the last snapshot
+  byte baselineSnapshot[13]; ///< Baseline registers from the last snapshot
+  unsigned long resetCount; ///< Number of resets detected
+  unsigned long lastRecoveryMicros; ///< How long the last recovery took
+
+  /**
+   * Saves charge settings and baselines.
+   */
+  void takeSnapshot();
+
+public:
+  /**
+   * Creates a reset monitor for an mpr121.
+   */
+  mpr121ResetMonitor(mpr121 &mpr);
+
+  byte checkInterval; ///< Check for resets every this many update() calls (default 32, 0 to only check when check() is called)
+  byte snapshotInterval; ///< Save charge settings and baselines every this many checks while running (default 16, 0 to only save in begin())
+
+  /**
+   * Saves charge settings and baselines.
+   * Call this after start() once auto-configuration has finished (a few hundred ms is plenty).
+   * Without a snapshot, recovery has to run auto-configuration again.
+   */
+  void begin();
+
+  /**
+   * Reads touch state, and checks for a reset every checkInterval calls.
+   * Call this regularly instead of mpr121::readTouchState().
+   *
+   * Returns the 13 touch state bits (0 if the device was just recovered).
+   */
+  short update();
+
+  /**
+   * Checks for a reset now, and recovers if there was one.
+   * Returns true if a reset was detected.
+   */
+  bool check();
+
+  /**
+   * Writes the register image, charge settings, and baselines back (whether there was a reset or not).
+   */
+  void recover();
+
+  /**
+   * Gets the number of resets detected.
+   */
+  unsigned long getResetCount() {
+    return resetCount;
+  }
+
+  /**
+   * Gets how long the last recovery took (μs).
+   */
+  unsigned long getLastRecoveryMicros() {
+    return lastRecoveryMicros;
+  }
+};
+
+#endif // MPR121_FEATURE_APPLY
@@ -0,0 +1,161 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Fixed-point sliders and wheels.
+ * More info in QuickMpr121Slider.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Slider.h"
+
+#if MPR121_FEATURE_ANALOG
+
+// Creates a slider or wheel.
+// electrodes: Array of electrodes in order along the slider (must stay valid while the slider is used).
+// count: Number of electrodes (max MPR121_SLIDER_MAX_ELECTRODES).
+//        The slider stops before the first invalid electrode (no device, or an electrode number above 12).
+// wheel: If true, the last electrode is next to the first one.
+mpr121Slider::mpr121Slider(const mpr121SliderElectrode* electrodes, byte count, bool wheel)
+{
+  if (count > MPR121_SLIDER_MAX_ELECTRODES)
+    count = MPR121_SLIDER_MAX_ELECTRODES;
+
+  // update() uses electrode numbers to index delta reads, so they must be in range
+  for (byte i = 0; i < count; i++) {
+    if (!electrodes[i].mpr || electrodes[i].electrode > 12) {
+      count = i;
+      break;
+    }
+  }
+
+  this->electrodes = electrodes;
+  this->count = count;
+  this->wheel = wheel;
+
+  touched = false;
+  smoothPosition = 0;
+  smoothVelocity = 0;
+
+  touchThreshold = 15;
+  smoothing = 2;
+}
+
+
+// Wraps a position difference to the shortest direction around a wheel.
+long mpr121Slider::wrapDifference(long difference) {
+  if (!wheel)
+    return difference;
+
+  long range = (long)count * MPR121_SLIDER_STEPS << 8;
+  if (difference > range / 2)
+    difference -= range;
+  else if (difference < -range / 2)
+    difference += range;
+
+  return difference;
+}
+
+
+// Reads all electrodes and updates position and velocity.
+// Returns whether the slider is touched.
+bool mpr121Slider::update() {
+  short signal[MPR121_SLIDER_MAX_ELECTRODES];
+
+  // read one delta burst for each device, covering all of its electrodes
+  for (byte i = 0; i < count; i++) {
+    mpr121* mpr = electrodes[i].mpr;
+
+    bool alreadyRead = false;
+    for (byte j = 0; j < i; j++) {
+      if (electrodes[j].mpr == mpr) {
+        alreadyRead = true;
+        break;
+      }
+    }
+    if (alreadyRead)
+      continue;
+
+    byte first = electrodes[i].electrode;
+    byte last = first;
+    for (byte j = i + 1; j < count; j++) {
+      if (electrodes[j].mpr == mpr) {
+        if (electrodes[j].electrode < first)
+          first = electrodes[j].electrode;
+        if (electrodes[j].electrode > last)
+          last = electrodes[j].electrode;
+      }
+    }
+
+    short* deltas = mpr->readElectrodeDelta(first, last - first + 1);
+
+    for (byte j = i; j < count; j++) {
+      if (electrodes[j].mpr == mpr) {
+        short value = -deltas[electrodes[j].electrode - first]; // touches reduce filtered data
+        signal[j] = value > 0 ? value : 0;
+      }
+    }
+  }
+
+  // find the strongest electrode
+  byte peak = 0;
+  for (byte i = 1; i < count; i++) {
+    if (signal[i] > signal[peak])
+      peak = i;
+  }
+
+  if (count == 0 || signal[peak] < touchThreshold) {
+    touched = false;
+    smoothVelocity = 0;
+    return false;
+  }
+
+  // interpolate using the peak and its neighbours
+  // (further electrodes only add noise, and would pull wheel positions towards the middle)
+  long weightSum = signal[peak];
+  long offsetSum = 0;
+
+  if (peak > 0 || wheel) {
+    byte prev = peak > 0 ? peak - 1 : count - 1;
+    weightSum += signal[prev];
+    offsetSum -= signal[prev];
+  }
+  if (peak < count - 1 || wheel) {
+    byte next = peak < count - 1 ? peak + 1 : 0;
+    weightSum += signal[next];
+    offsetSum += signal[next];
+  }
+
+  long position = (long)peak * MPR121_SLIDER_STEPS + offsetSum * MPR121_SLIDER_STEPS / weightSum;
+  if (wheel && position < 0)
+    position += (long)count * MPR121_SLIDER_STEPS;
+
+  long rawPosition = position << 8;
+
+  if (!touched) {
+    // new touch, jump straight to the position
+    touched = true;
+    smoothPosition = rawPosition;
+    smoothVelocity = 0;
+    return true;
+  }
+
+  long difference = wrapDifference(rawPosition - smoothPosition);
+  long step = difference >> smoothing;
+  smoothPosition += step;
+
+  if (wheel) {
+    long range = (long)count * MPR121_SLIDER_STEPS << 8;
+    if (smoothPosition < 0)
+      smoothPosition += range;
+    else if (smoothPosition >= range)
+      smoothPosition -= range;
+  }
+
+  smoothVelocity += (step - smoothVelocity) >> smoothing;
+
+  return true;
+}
+
+#endif // MPR121_FEATURE_ANALOG
@@ -0,0 +1,93 @@
+/** \file QuickMpr121Slider.h
+ * fixed-point sliders and wheels for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+#if MPR121_FEATURE_ANALOG
+
+/// Max number of electrodes in one slider or wheel
+#define MPR121_SLIDER_MAX_ELECTRODES 24
+
+/// Position units per electrode (positions are fixed-point with this many steps between electrode centres)
+#define MPR121_SLIDER_STEPS 256
+
+
+/**
+ * One electrode of a slider or wheel.
+ */
+struct mpr121SliderElectrode {
+  mpr121* mpr; ///< Device the electrode is on
+  byte electrode; ///< Electrode number on that device
+};
+
+
+/**
+ * A slider or wheel built from consecutive electrodes, which can span multiple devices.
+ *
+ * Each update reads delta values once per device (see mpr121::readElectrodeDelta()), then interpolates position around the strongest electrode.
+ * Everything uses integer math, so it's cheap on MCUs without an FPU.
+ */
+class mpr121Slider {
+private:
+  const mpr121SliderElectrode* electrodes; ///< Electrodes from constructor
+  byte count; ///< Number of electrodes from constructor
+  bool wheel; ///< Whether the ends wrap around
+  bool touched; ///< Whether the slider was touched at the last update
+  long smoothPosition; ///< Smoothed position, in 1/256ths of position units
+  long smoothVelocity; ///< Smoothed velocity, in 1/256ths of position units per update
+
+  /**
+   * Wraps a position difference to the shortest direction around a wheel.
+   */
+  long wrapDifference(long difference);
+
+public:
+  /**
+   * Creates a slider or wheel.
+   *
+   * \param electrodes  Array of electrodes in order along the slider (must stay valid while the slider is used).
+   * \param count       Number of electrodes (max MPR121_SLIDER_MAX_ELECTRODES).
+   *                    The slider stops before the first invalid electrode (no device, or an electrode number above 12).
+   * \param wheel       If true, the last electrode is next to the first one.
+   */
+  mpr121Slider(const mpr121SliderElectrode* electrodes, byte count, bool wheel = false);
+
+  short touchThreshold; ///< Minimum signal (`(baseline << 2) - filtered`) on the strongest electrode to count as touched
+  byte smoothing; ///< Smoothing strength -- each update moves position and velocity by 1/2^smoothing of the way to the new value (0 disables smoothing)
+
+  /**
+   * Reads all electrodes and updates position and velocity.
+   * Returns whether the slider is touched.
+   */
+  bool update();
+
+  /**
+   * Gets whether the slider was touched at the last update.
+   */
+  bool isTouched() {
+    return touched;
+  }
+
+  /**
+   * Gets the smoothed position.
+   * Electrode n is at n * MPR121_SLIDER_STEPS. Wheels wrap at count * MPR121_SLIDER_STEPS.
+   * Keeps the last value while not touched.
+   */
+  long getPosition() {
+    return smoothPosition >> 8;
+  }
+
+  /**
+   * Gets the smoothed velocity, in position units per update.
+   * Resets to 0 when a new touch starts.
+   */
+  long getVelocity() {
+    return smoothVelocity >> 8;
+  }
+};
+
+#endif // MPR121_FEATURE_ANALOG
@@ -0,0 +1,163 @@
+/** \file QuickMpr121Template.h
+ * compile-time specialised mpr121 for fixed electrode layouts
+ * 
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+
+/**
+ * A fixed electrode layout for mpr121T.
+ * 
+ * \tparam ELECTRODES  Number of sensing electrodes, starting from ELE0 (the same as would be passed to mpr121::start()).
+ * \tparam PROX        Electrodes used for proximity detection.
+ * \tparam GPIO_FIRST  First GPIO pin (4-11, must be after the sensing electrodes).
+ * \tparam GPIO_COUNT  Number of consecutive GPIO pins (0 if GPIO isn't used).
+ */
+template<byte ELECTRODES, mpr121ElectrodeConfigProx PROX = MPR_ELEPROX_DISABLED, byte GPIO_FIRST = 12, byte GPIO_COUNT = 0>
+struct mpr121Layout {
+  static_assert(ELECTRODES <= 12, "MPR121 only has 12 sensing electrodes");
+  static_assert(GPIO_COUNT == 0 || (GPIO_FIRST >= 4 && GPIO_FIRST + GPIO_COUNT <= 12), "GPIO is only available on pins 4-11");
+  static_assert(GPIO_COUNT == 0 || GPIO_FIRST >= ELECTRODES, "GPIO pins can't be used for sensing");
+
+  static const byte electrodes = ELECTRODES; ///< Number of sensing electrodes
+  static const mpr121ElectrodeConfigProx prox = PROX; ///< Proximity detection setting
+  static const byte gpioFirst = GPIO_FIRST; ///< First GPIO pin
+  static const byte gpioCount = GPIO_COUNT; ///< Number of GPIO pins
+
+  static const byte gpioMask = ((1 << GPIO_COUNT) - 1) << (GPIO_FIRST - 4); ///< Mask for GPIO registers (bit 0 is pin 4)
+  static const short statusMask = ((1 << ELECTRODES) - 1) | ((short)gpioMask << 4) | (PROX != MPR_ELEPROX_DISABLED ? 1 << 12 : 0); ///< Mask for used touch status bits
+  static const byte statusBytes = statusMask > 0xff ? 2 : 1; ///< Number of touch status bytes that need to be read
+};
+
+
+/**
+ * An mpr121 specialised for a fixed electrode layout (see mpr121Layout).
+ * 
+ * Read sizes, masks, and pin numbers are resolved at compile time, so reads are as short as possible and there are no runtime bounds checks.
+ * All normal mpr121 functions are still available too.
+ * 
+ * Example: `mpr121T<mpr121Layout<8, MPR_ELEPROX_DISABLED, 8, 4>> mpr;` for 8 touch electrodes and LEDs on 8-11.
+ */
+template<class Layout>
+class mpr121T : public mpr121 {
+public:
+  using mpr121::mpr121;
+  using mpr121::start;
+  using mpr121::readTouchState;
+  #if MPR121_FEATURE_ANALOG
+    using mpr121::readElectrodeData;
+  #endif
+  #if MPR121_FEATURE_GPIO
+    using mpr121::setGPIOMode;
+  #endif
+
+  /**
+   * Applies settings and enters run mode with the layout's electrodes and proximity detection.
+   * If MPR121_CONFIG_PROFILES is true, proximity detection comes from the profile, so this is only available for layouts without it
+   * (for other layouts, set proxEnable in the profile and use `start(Layout::electrodes)`).
+   */
+  void start() {
+    #if MPR121_CONFIG_PROFILES
+      static_assert(Layout::prox == MPR_ELEPROX_DISABLED, "with MPR121_CONFIG_PROFILES, proximity detection must be set in the profile (use start(Layout::electrodes))");
+    #else
+      proxEnable = Layout::prox;
+    #endif
+    mpr121::start(Layout::electrodes);
+  }
+
+  /**
+   * Reads the touch state bits used by the layout (including GPIO inputs and ELEPROX).
+   * Only reads the second status byte if it's needed.
+   */
+  short readTouchStateFast() {
+    byte* rawdata = readRegister(MPRREG_ELE0_TO_ELE7_TOUCH_STATUS, Layout::statusBytes);
+    short state = rawdata[0];
+    if (Layout::statusBytes > 1)
+      state |= rawdata[1] << 8;
+    return state & Layout::statusMask;
+  }
+
+  /**
+   * Reads the touch state of one electrode or GPIO pin (only one status byte is read).
+   */
+  template<byte ELECTRODE>
+  bool readTouchState() {
+    static_assert((Layout::statusMask >> ELECTRODE) & 1, "electrode isn't used by this layout");
+    return bitRead(readRegister(ELECTRODE < 8 ? MPRREG_ELE0_TO_ELE7_TOUCH_STATUS : MPRREG_ELE8_TO_ELEPROX_TOUCH_STATUS, 1)[0], ELECTRODE % 8);
+  }
+
+  #if MPR121_FEATURE_ANALOG
+    /**
+     * Reads filtered analog data for all sensing electrodes in one burst.
+     */
+    short* readElectrodeData() {
+      static_assert(Layout::electrodes > 0, "layout has no sensing electrodes");
+    
+      byte* rawdata = readRegister(MPRREG_ELE0_FILTERED_DATA_LSB, Layout::electrodes * 2);
+      for (byte i = 0; i < Layout::electrodes; i++) {
+        electrodeDataBuf[i] = rawdata[i*2] | ((rawdata[i*2 + 1] & 0b00000011) << 8);
+      }
+      return electrodeDataBuf;
+    }
+
+    /**
+     * Reads filtered analog data for one electrode.
+     */
+    template<byte ELECTRODE>
+    short readElectrodeData() {
+      static_assert(ELECTRODE < Layout::electrodes || (ELECTRODE == MPR_ELEPROX && Layout::prox != MPR_ELEPROX_DISABLED), "electrode isn't used by this layout");
+    
+      byte* rawdata = readRegister((mpr121Register)(MPRREG_ELE0_FILTERED_DATA_LSB + ELECTRODE*2), 2);
+      return rawdata[0] | ((rawdata[1] & 0b00000011) << 8);
+    }
+  #endif
+
+  #if MPR121_FEATURE_GPIO
+    /**
+     * Sets the mode of all the layout's GPIO pins.
+     * Each GPIO register is only read and written once.
+     */
+    void setGPIOMode(mpr121GPIOMode mode) {
+      static_assert(Layout::gpioCount > 0, "layout has no GPIO pins");
+      const byte mask = Layout::gpioMask;
+
+      // disable the modified outputs while changing stuff around
+      byte enableByte = readRegister(MPRREG_GPIO_ENABLE) & ~mask;
+      writeRegister(MPRREG_GPIO_ENABLE, enableByte);
+
+      if (mode == MPR_GPIO_MODE_DISABLED)
+        return;
+
+      // settings are bit-packed into the enum (see mpr121::setGPIOMode)
+      // control 0, control 1, and direction are consecutive, so read and write them in one burst each
+      byte regs[4];
+      memcpy(regs, readRegister(MPRREG_GPIO_CONTROL_0, 4), 4); // control 0, control 1, data, direction
+      regs[0] = bitRead(mode, 1) ? (regs[0] | mask) : (regs[0] & ~mask);
+      regs[1] = bitRead(mode, 0) ? (regs[1] | mask) : (regs[1] & ~mask);
+      regs[3] = bitRead(mode, 2) ? (regs[3] | mask) : (regs[3] & ~mask);
+      writeRegister(MPRREG_GPIO_CONTROL_0, regs, 2);
+      writeRegister(MPRREG_GPIO_DIRECTION, regs[3]);
+
+      writeRegister(MPRREG_GPIO_ENABLE, enableByte | mask);
+    }
+
+    /**
+     * Writes digital values to all the layout's GPIO pins.
+     * Bit 0 of values is the first GPIO pin.
+     * 
+     * Unlike mpr121::writeGPIODigital, this doesn't clear PWM values (use writeGPIOAnalog(pin, 0) first if PWM was used).
+     */
+    void writeGPIO(byte values) {
+      static_assert(Layout::gpioCount > 0, "layout has no GPIO pins");
+      byte shifted = values << (Layout::gpioFirst - 4);
+    
+      if (shifted & Layout::gpioMask)
+        writeRegister(MPRREG_GPIO_DATA_SET, shifted & Layout::gpioMask);
+      if (~shifted & Layout::gpioMask)
+        writeRegister(MPRREG_GPIO_DATA_CLEAR, ~shifted & Layout::gpioMask);
+    }
+  #endif
+};
@@ -0,0 +1,133 @@
+/*
+ * QuickMpr121 Arduino library by somewhatlurker
+ * =============================================
+ *
+ * Noise-driven filter tuning.
+ * More info in QuickMpr121Tuner.h, or read the docs.
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#include "QuickMpr121Tuner.h"
+
+#if MPR121_FEATURE_ANALOG && !MPR121_CONFIG_PROFILES
+
+// Creates a filter tuner for an mpr121.
+// electrodes: Number of electrodes to scan (the same as would be passed to mpr121::start()).
+mpr121FilterTuner::mpr121FilterTuner(mpr121 &mpr, byte electrodes)
+{
+  if (electrodes > 12)
+    electrodes = 12;
+
+  this->mpr = &mpr;
+  this->electrodes = electrodes;
+
+  for (byte i = 0; i < 12; i++) {
+    variance[i] = 0;
+  }
+
+  noiseMargin = 4;
+  samples = 32;
+  settleResponses = 4;
+}
+
+
+// Gets the response time in ms (SFI samples * ESI ms) for filter settings.
+unsigned short mpr121FilterTuner::getResponseTime(mpr121FilterSFI SFI, mpr121FilterESI ESI) {
+  const byte sfiSamples[] = { 4, 6, 10, 18 };
+  return sfiSamples[SFI & 0b11] << (ESI & 0b111);
+}
+
+
+// Restarts with the given settings and measures noise.
+// Returns true if all electrodes are within their thresholds.
+bool mpr121FilterTuner::measure(mpr121FilterFFI FFI, mpr121FilterSFI SFI, mpr121FilterESI ESI) {
+  mpr->FFI = FFI;
+  mpr->SFI = SFI;
+  mpr->ESI = ESI;
+  mpr->start(electrodes);
+
+  delay((unsigned long)settleResponses * getResponseTime(SFI, ESI));
+
+  // Welford's algorithm, with data in 1/16ths so rounding the mean at each step barely affects it
+  // (10-bit data * 16 is small enough that squared differences fit in a long)
+  long mean[12];
+  unsigned long m2[12];
+  for (byte i = 0; i < electrodes; i++) {
+    mean[i] = 0;
+    m2[i] = 0;
+  }
+
+  for (unsigned short n = 1; n <= samples; n++) { // byte would overflow (and never finish) with samples = 255
+    short* data = mpr->readElectrodeData(0, electrodes);
+
+    for (byte i = 0; i < electrodes; i++) {
+      long x = (long)data[i] << 4;
+      long delta = x - mean[i];
+      // round to nearest, so truncation doesn't make the mean drift towards 0 (which would inflate the variance)
+      mean[i] += (delta >= 0 ? delta + n / 2 : delta - n / 2) / n;
+      m2[i] += (delta * (x - mean[i]) + 8) >> 4;
+    }
+
+    delay(1 << ESI); // wait for new data
+  }
+
+  bool ok = true;
+  for (byte i = 0; i < electrodes; i++) {
+    variance[i] = samples > 1 ? m2[i] / (samples - 1) : 0;
+
+    // compare variance * margin^2 against threshold^2 to avoid square roots
+    byte threshold = mpr->touchThresholds[i] < mpr->releaseThresholds[i] ? mpr->touchThresholds[i] : mpr->releaseThresholds[i];
+    if (variance[i] * noiseMargin * noiseMargin > ((unsigned long)threshold * threshold << 4))
+      ok = false;
+  }
+
+  return ok;
+}
+
+
+// Finds the fastest filter settings with acceptable noise, writes them to the mpr121's FFI, SFI, and ESI, and restarts it.
+// Returns true if a suitable candidate was found. If not, the original settings are restored and false is returned.
+bool mpr121FilterTuner::tune() {
+  mpr121FilterFFI oldFFI = mpr->FFI;
+  mpr121FilterSFI oldSFI = mpr->SFI;
+  mpr121FilterESI oldESI = mpr->ESI;
+
+  // sort SFI/ESI candidates by response time, then ESI (faster sampling is better for equal response times)
+  byte candidates[32]; // (SFI << 3) | ESI
+  for (byte i = 0; i < 32; i++) {
+    candidates[i] = i;
+  }
+  for (byte i = 1; i < 32; i++) {
+    byte c = candidates[i];
+    unsigned short response = getResponseTime((mpr121FilterSFI)(c >> 3), (mpr121FilterESI)(c & 0b111));
+
+    byte j = i;
+    for ( ; j > 0; j--) {
+      byte prev = candidates[j - 1];
+      unsigned short prevResponse = getResponseTime((mpr121FilterSFI)(prev >> 3), (mpr121FilterESI)(prev & 0b111));
+      if (prevResponse < response || (prevResponse == response && (prev & 0b111) <= (c & 0b111)))
+        break;
+      candidates[j] = prev;
+    }
+    candidates[j] = c;
+  }
+
+  for (byte i = 0; i < 32; i++) {
+    mpr121FilterSFI SFI = (mpr121FilterSFI)(candidates[i] >> 3);
+    mpr121FilterESI ESI = (mpr121FilterESI)(candidates[i] & 0b111);
+
+    for (byte FFI = MPR_FFI_6; FFI <= MPR_FFI_34; FFI++) {
+      if (measure((mpr121FilterFFI)FFI, SFI, ESI))
+        return true; // the mpr121 is already running with these settings
+    }
+  }
+
+  mpr->FFI = oldFFI;
+  mpr->SFI = oldSFI;
+  mpr->ESI = oldESI;
+  mpr->start(electrodes);
+  return false;
+}
+
+#endif // MPR121_FEATURE_ANALOG && !MPR121_CONFIG_PROFILES
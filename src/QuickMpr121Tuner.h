@@ -0,0 +1,69 @@
+/** \file QuickMpr121Tuner.h
+ * noise-driven filter tuning for QuickMpr121
+ *
+ * Copyright 2020 somewhatlurker, MIT license
+ */
+
+#pragma once
+#include "QuickMpr121.h"
+
+#if MPR121_FEATURE_ANALOG && !MPR121_CONFIG_PROFILES
+
+/**
+ * Picks the fastest filter settings (FFI, SFI, and ESI) that keep electrode noise well below the touch and release thresholds.
+ *
+ * Candidates are tried in order of response time (SFI samples * ESI ms), and with each candidate FFI from lowest to highest.
+ * For each one, the mpr121 is restarted (so auto-configuration adapts to it) and filtered data is sampled,
+ * with variance tracked incrementally (Welford's algorithm) so no history is stored.
+ * The first candidate where every electrode's standard deviation * noiseMargin is within its lowest threshold wins.
+ *
+ * Tuning can take a while for noisy installations (slow candidates take over a second each), so run it at setup or on request rather than regularly.
+ * Set thresholds before tuning.
+ *
+ * Not available if MPR121_CONFIG_PROFILES is true (tune with profiles disabled, then copy FFI, SFI, and ESI into the profile).
+ */
+class mpr121FilterTuner {
+private:
+  mpr121* mpr; ///< Device from constructor
+  byte electrodes; ///< Number of electrodes from constructor
+  unsigned long variance[12]; ///< Variance of each electrode for the last measured candidate, in 1/16ths
+
+  /**
+   * Restarts with the given settings and measures noise.
+   * Returns true if all electrodes are within their thresholds.
+   */
+  bool measure(mpr121FilterFFI FFI, mpr121FilterSFI SFI, mpr121FilterESI ESI);
+
+public:
+  /**
+   * Creates a filter tuner for an mpr121.
+   *
+   * \param mpr         The device to tune.
+   * \param electrodes  Number of electrodes to scan (the same as would be passed to mpr121::start()).
+   */
+  mpr121FilterTuner(mpr121 &mpr, byte electrodes = 12);
+
+  byte noiseMargin; ///< Required ratio of the lowest threshold to the noise standard deviation (default 4)
+  byte samples; ///< Number of samples taken for each candidate (default 32, max 255)
+  byte settleResponses; ///< Wait this many response times after starting before sampling, to let auto-configuration and filters settle (default 4)
+
+  /**
+   * Finds the fastest filter settings with acceptable noise, writes them to the mpr121's FFI, SFI, and ESI, and restarts it.
+   * Returns true if a suitable candidate was found. If not, the original settings are restored and false is returned.
+   */
+  bool tune();
+
+  /**
+   * Gets the noise variance for one electrode with the last measured candidate (in 1/16ths of filtered data units squared).
+   */
+  unsigned long getVariance(byte electrode) {
+    return electrode < 12 ? variance[electrode] : 0;
+  }
+
+  /**
+   * Gets the response time in ms (SFI samples * ESI ms) for filter settings.
+   */
+  static unsigned short getResponseTime(mpr121FilterSFI SFI, mpr121FilterESI ESI);
+};
+
+#endif // MPR121_FEATURE_ANALOG && !MPR121_CONFIG_PROFILES